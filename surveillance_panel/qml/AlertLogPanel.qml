@@ -19,6 +19,24 @@ Rectangle {
     // Popover state
     property int activePopoverIndex: -1
     
+    // Filtered view of the log; row indices passed to alertLog are mapped
+    // back with sourceRow()
+    AlertFilterModel {
+        id: alertFilter
+        alertLogModel: alertLog
+    }
+    
+    // Exports finish asynchronously
+    Connections {
+        target: alertLog
+        
+        function onExportFinished(filePath, format, success, error) {
+            if (success) {
+                root.exportRequested(filePath, format)
+            }
+        }
+    }
+    
     ColumnLayout {
         anchors.fill: parent
         anchors.margins: 16
@@ -41,7 +59,9 @@ Rectangle {
             Text {
                 text: selectionMode && selectedIndices.length > 0 ? 
                       selectedIndices.length + " selected" : 
-                      "Total: " + alertLog.count
+                      (alertFilter.count < alertLog.count
+                       ? "Showing " + alertFilter.count + " of " + alertLog.totalCount
+                       : "Total: " + alertLog.totalCount)
                 font.pixelSize: 14
                 color: selectionMode && selectedIndices.length > 0 ? "#3498db" : "#95a5a6"
                 Layout.fillWidth: true
@@ -106,9 +126,7 @@ Rectangle {
                         onTriggered: {
                             var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
                             var filePath = logsDir + "/alerts_selected_" + timestamp + ".csv"
-                            if (alertLog.exportSelectedToCsv(filePath, selectedIndices)) {
-                                root.exportRequested(filePath, "csv")
-                            }
+                            alertLog.exportSelectedToCsv(filePath, selectedIndices)
                         }
                     }
                     
@@ -117,9 +135,7 @@ Rectangle {
                         onTriggered: {
                             var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
                             var filePath = logsDir + "/alerts_selected_" + timestamp + ".json"
-                            if (alertLog.exportSelectedToJson(filePath, selectedIndices)) {
-                                root.exportRequested(filePath, "json")
-                            }
+                            alertLog.exportSelectedToJson(filePath, selectedIndices)
                         }
                     }
                 }
@@ -161,6 +177,81 @@ Rectangle {
             }
         }
         
+        // Filters
+        RowLayout {
+            Layout.fillWidth: true
+            spacing: 8
+            
+            ComboBox {
+                id: typeFilterBox
+                Layout.fillWidth: true
+                model: [""].concat(alertFilter.types)
+                displayText: currentIndex > 0 ? currentText : "All types"
+                onActivated: alertFilter.typeFilter = currentIndex > 0 ? currentText : ""
+            }
+            
+            ComboBox {
+                id: cameraFilterBox
+                Layout.fillWidth: true
+                model: [""].concat(alertFilter.cameraNames)
+                displayText: currentIndex > 0 ? currentText : "All cameras"
+                onActivated: alertFilter.cameraFilter = currentIndex > 0 ? currentText : ""
+            }
+            
+            ComboBox {
+                id: timeFilterBox
+                Layout.fillWidth: true
+                model: ["All time", "Last hour", "Last 24 hours", "Last 7 days"]
+                onActivated: {
+                    var hours = [0, 1, 24, 24 * 7][currentIndex]
+                    alertFilter.since = hours > 0
+                        ? new Date(Date.now() - hours * 60 * 60 * 1000)
+                        : new Date(NaN)
+                }
+            }
+        }
+        
+        TextField {
+            Layout.fillWidth: true
+            placeholderText: "Search messages and cameras"
+            onTextChanged: alertFilter.textFilter = text
+        }
+        
+        // Export progress; exports run in the background
+        RowLayout {
+            Layout.fillWidth: true
+            spacing: 8
+            visible: alertLog.exporting
+            
+            ProgressBar {
+                Layout.fillWidth: true
+                from: 0
+                to: 1
+                value: alertLog.exportProgress
+            }
+            
+            Button {
+                text: "Cancel export"
+                Layout.preferredHeight: 28
+                
+                background: Rectangle {
+                    color: parent.hovered ? "#c0392b" : "#e74c3c"
+                    radius: 4
+                }
+                
+                contentItem: Text {
+                    text: parent.text
+                    font.pixelSize: 12
+                    font.bold: true
+                    color: "#ffffff"
+                    horizontalAlignment: Text.AlignHCenter
+                    verticalAlignment: Text.AlignVCenter
+                }
+                
+                onClicked: alertLog.cancelExport()
+            }
+        }
+        
         // Alert list
         Rectangle {
             Layout.fillWidth: true
@@ -175,13 +266,41 @@ Rectangle {
                 anchors.fill: parent
                 anchors.margins: 4
                 clip: true
-                model: alertLog
+                model: alertFilter
                 spacing: 4
                 
                 ScrollBar.vertical: ScrollBar {
                     policy: ScrollBar.AsNeeded
                 }
                 
+                // Older alerts evicted from memory are paged back in on demand
+                header: Item {
+                    width: alertListView.width - 8
+                    height: alertLog.hasOlderAlerts ? 40 : 0
+                    visible: alertLog.hasOlderAlerts
+                    
+                    Button {
+                        anchors.fill: parent
+                        anchors.bottomMargin: 4
+                        text: "Load older alerts (" + (alertLog.totalCount - alertLog.count) + ")"
+                        
+                        background: Rectangle {
+                            color: parent.hovered ? "#4a6278" : "#3d566e"
+                            radius: 4
+                        }
+                        
+                        contentItem: Text {
+                            text: parent.text
+                            font.pixelSize: 12
+                            color: "#ecf0f1"
+                            horizontalAlignment: Text.AlignHCenter
+                            verticalAlignment: Text.AlignVCenter
+                        }
+                        
+                        onClicked: alertLog.loadOlderAlerts(100)
+                    }
+                }
+                
                 delegate: Rectangle {
                     id: alertDelegate
                     
@@ -199,7 +318,7 @@ Rectangle {
                     }
                     border.width: isSelected ? 3 : 2
                     
-                    property bool isSelected: selectedIndices.indexOf(index) >= 0
+                    property bool isSelected: selectedIndices.indexOf(alertFilter.sourceRow(index)) >= 0
                     property bool isSnapshot: model.type === "snapshot"
                     
                     RowLayout {
@@ -215,9 +334,10 @@ Rectangle {
                             
                             onToggled: {
                                 var newSelected = selectedIndices.slice()
-                                var idx = newSelected.indexOf(index)
+                                var row = alertFilter.sourceRow(index)
+                                var idx = newSelected.indexOf(row)
                                 if (checked && idx < 0) {
-                                    newSelected.push(index)
+                                    newSelected.push(row)
                                 } else if (!checked && idx >= 0) {
                                     newSelected.splice(idx, 1)
                                 }
@@ -242,7 +362,18 @@ Rectangle {
                                 }
                             }
                         }
-                        
+
+                        // Snapshot thumbnail, encoded once off the GUI thread
+                        Image {
+                            visible: model.hasThumbnail
+                            Layout.preferredWidth: 85
+                            Layout.preferredHeight: 64
+                            Layout.alignment: Qt.AlignVCenter
+                            source: model.hasThumbnail ? "image://alerts/thumb/" + model.id : ""
+                            fillMode: Image.PreserveAspectFit
+                            asynchronous: true
+                        }
+
                         // Alert content
                         ColumnLayout {
                             Layout.fillWidth: true
@@ -254,12 +385,16 @@ Rectangle {
                                 spacing: 8
                                 
                                 Text {
-                                    text: Qt.formatDateTime(model.timestamp, "hh:mm:ss")
+                                    // Merged repeats show the span from first to last occurrence
+                                    text: model.repeatCount > 1
+                                          ? Qt.formatDateTime(model.timestamp, "hh:mm:ss") + " - " +
+                                            Qt.formatDateTime(model.lastTimestamp, "hh:mm:ss")
+                                          : Qt.formatDateTime(model.timestamp, "hh:mm:ss")
                                     font.pixelSize: 12
                                     font.bold: true
                                     color: "#ecf0f1"
                                 }
-                                
+
                                 Rectangle {
                                     width: 60
                                     height: 18
@@ -286,7 +421,23 @@ Rectangle {
                                         color: "#ffffff"
                                     }
                                 }
-                                
+
+                                Text {
+                                    visible: model.repeatCount > 1
+                                    text: "x" + model.repeatCount
+                                    font.pixelSize: 12
+                                    font.bold: true
+                                    color: "#f1c40f"
+                                }
+
+                                Text {
+                                    visible: model.clipPath !== ""
+                                    text: "🎞 CLIP"
+                                    font.pixelSize: 10
+                                    font.bold: true
+                                    color: "#1abc9c"
+                                }
+
                                 Item { Layout.fillWidth: true }
                             }
                             
@@ -316,7 +467,7 @@ Rectangle {
                         onClicked: {
                             // Show popover for this alert
                             activePopoverIndex = index
-                            alertPopover.alertIndex = index
+                            alertPopover.alertIndex = alertFilter.sourceRow(index)
                             alertPopover.alertType = model.type
                             alertPopover.parent = alertDelegate
                             alertPopover.open()
@@ -516,9 +667,7 @@ FileDialog {
             onTriggered: {
                 var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
                 var filePath = logsDir + "/alert_" + saveMenu.alertIndex + "_" + timestamp + ".csv"
-                if (alertLog.exportSelectedToCsv(filePath, [saveMenu.alertIndex])) {
-                    root.exportRequested(filePath, "csv")
-                }
+                alertLog.exportSelectedToCsv(filePath, [saveMenu.alertIndex])
             }
         }
         
@@ -527,9 +676,7 @@ FileDialog {
             onTriggered: {
                 var timestamp = Qt.formatDateTime(new Date(), "yyyyMMdd_HHmmss")
                 var filePath = logsDir + "/alert_" + saveMenu.alertIndex + "_" + timestamp + ".json"
-                if (alertLog.exportSelectedToJson(filePath, [saveMenu.alertIndex])) {
-                    root.exportRequested(filePath, "json")
-                }
+                alertLog.exportSelectedToJson(filePath, [saveMenu.alertIndex])
             }
         }
     }
@@ -189,10 +189,7 @@ Rectangle {
                     anchors.fill: parent
                     fillMode: Image.PreserveAspectFit
                     source: available && cameraStream ? 
-                            ("image://camera" + cameraIndex + "/frame?" + 
-                             (cameraIndex === 1 ? frameCounter1 :
-                              cameraIndex === 2 ? frameCounter2 :
-                              cameraIndex === 3 ? frameCounter3 : frameCounter4)) : ""
+                            ("image://camera/" + cameraStream.id + "/" + cameraStream.frameSequence) : ""
                     cache: false
                     asynchronous: false
                     
@@ -475,10 +472,7 @@ Rectangle {
                         anchors.fill: parent
                         fillMode: Image.PreserveAspectFit
                         source: available && cameraStream ? 
-                                ("image://camera" + cameraIndex + "/frame?" + 
-                                 (cameraIndex === 1 ? frameCounter1 :
-                                  cameraIndex === 2 ? frameCounter2 :
-                                  cameraIndex === 3 ? frameCounter3 : frameCounter4)) : ""
+                                ("image://camera/" + cameraStream.id + "/" + cameraStream.frameSequence) : ""
                         cache: false
                         asynchronous: false
                         
@@ -1175,6 +1169,41 @@ Rectangle {
                                         }
                                     }
                                 }
+
+                                RowLayout {
+                                    Layout.fillWidth: true
+                                    spacing: 12
+                                    
+                                    Label {
+                                        text: "Record event clips"
+                                        color: "white"
+                                        font.pixelSize: 13
+                                        Layout.fillWidth: true
+                                    }
+                                    
+                                    CheckBox {
+                                        checked: cameraStream ? cameraStream.eventClipsEnabled : false
+                                        onToggled: if (cameraStream) cameraStream.eventClipsEnabled = checked
+                                        
+                                        indicator: Rectangle {
+                                            implicitWidth: 28
+                                            implicitHeight: 28
+                                            radius: 5
+                                            border.color: "#9b59b6"
+                                            border.width: 2
+                                            color: parent.checked ? "#9b59b6" : "#34495e"
+                                            
+                                            Text {
+                                                anchors.centerIn: parent
+                                                text: "✓"
+                                                color: "white"
+                                                font.pixelSize: 16
+                                                font.bold: true
+                                                visible: parent.parent.checked
+                                            }
+                                        }
+                                    }
+                                }
                             }
                         }
                         
@@ -1,6 +1,7 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
+import QtQml.Models
 
 ApplicationWindow {
     id: root
@@ -12,7 +13,7 @@ ApplicationWindow {
     title: "Multi-Camera Surveillance Panel"
     
     // State management for full-screen view
-    property int fullScreenIndex: -1  // -1 = grid view, 1-4 = specific camera
+    property int fullScreenIndex: -1  // -1 = grid view, otherwise 1-based camera index
     property bool alertLogVisible: false
     
     // Toast message function
@@ -37,57 +38,34 @@ ApplicationWindow {
                 SplitView.minimumWidth: 600
                 color: "#2c3e50"
                 
-                // Grid view (2x2 layout)
-                Grid {
+                // Grid view, sized to fit however many cameras are configured
+                GridView {
                     id: cameraGrid
                     anchors.fill: parent
                     anchors.margins: 16
-                    columns: 2
-                    rows: 2
-                    spacing: 16
+                    interactive: false
                     
-                    // Camera 1
-                    CameraTile {
-                        width: (parent.width - parent.spacing) / 2
-                        height: (parent.height - parent.spacing) / 2
-                        cameraIndex: 1
-                        cameraStream: cameraManager.camera1
-                        cameraName: cameraManager.cameraName(1)
-                        available: cameraManager.cameraAvailable(1)
-                        onFullScreenRequested: fullScreenIndex = 1
-                    }
+                    readonly property int spacing: 16
+                    readonly property int columns: Math.max(1, Math.ceil(Math.sqrt(count)))
+                    readonly property int rows: Math.max(1, Math.ceil(count / columns))
                     
-                    // Camera 2
-                    CameraTile {
-                        width: (parent.width - parent.spacing) / 2
-                        height: (parent.height - parent.spacing) / 2
-                        cameraIndex: 2
-                        cameraStream: cameraManager.camera2
-                        cameraName: cameraManager.cameraName(2)
-                        available: cameraManager.cameraAvailable(2)
-                        onFullScreenRequested: fullScreenIndex = 2
-                    }
+                    cellWidth: (width + spacing) / columns
+                    cellHeight: (height + spacing) / rows
+                    model: cameraManager
                     
-                    // Camera 3
-                    CameraTile {
-                        width: (parent.width - parent.spacing) / 2
-                        height: (parent.height - parent.spacing) / 2
-                        cameraIndex: 3
-                        cameraStream: cameraManager.camera3
-                        cameraName: cameraManager.cameraName(3)
-                        available: cameraManager.cameraAvailable(3)
-                        onFullScreenRequested: fullScreenIndex = 3
-                    }
-                    
-                    // Camera 4
-                    CameraTile {
-                        width: (parent.width - parent.spacing) / 2
-                        height: (parent.height - parent.spacing) / 2
-                        cameraIndex: 4
-                        cameraStream: cameraManager.camera4
-                        cameraName: cameraManager.cameraName(4)
-                        available: cameraManager.cameraAvailable(4)
-                        onFullScreenRequested: fullScreenIndex = 4
+                    delegate: Item {
+                        width: cameraGrid.cellWidth
+                        height: cameraGrid.cellHeight
+                        
+                        CameraTile {
+                            width: parent.width - cameraGrid.spacing
+                            height: parent.height - cameraGrid.spacing
+                            cameraIndex: model.cameraIndex
+                            cameraStream: model.stream
+                            cameraName: model.name
+                            available: model.available
+                            onFullScreenRequested: fullScreenIndex = model.cameraIndex
+                        }
                     }
                 }
                 
@@ -132,15 +110,7 @@ ApplicationWindow {
                 CameraTile {
                     anchors.fill: parent
                     cameraIndex: fullScreenIndex
-                    cameraStream: {
-                        switch(fullScreenIndex) {
-                            case 1: return cameraManager.camera1
-                            case 2: return cameraManager.camera2
-                            case 3: return cameraManager.camera3
-                            case 4: return cameraManager.camera4
-                            default: return null
-                        }
-                    }
+                    cameraStream: cameraManager.camera(fullScreenIndex)
                     cameraName: cameraManager.cameraName(fullScreenIndex)
                     available: cameraManager.cameraAvailable(fullScreenIndex)
                     isFullScreen: true
@@ -177,6 +147,7 @@ ApplicationWindow {
         }
         
         Menu {
+            id: viewMenu
             title: "&View"
             MenuItem {
                 text: "Grid View"
@@ -187,25 +158,18 @@ ApplicationWindow {
                 }
             }
             MenuSeparator {}
-            MenuItem {
-                text: "Camera 1 Fullscreen"
-                enabled: cameraManager.cameraAvailable(1) && fullScreenIndex !== 1
-                onTriggered: fullScreenIndex = 1
-            }
-            MenuItem {
-                text: "Camera 2 Fullscreen"
-                enabled: cameraManager.cameraAvailable(2) && fullScreenIndex !== 2
-                onTriggered: fullScreenIndex = 2
-            }
-            MenuItem {
-                text: "Camera 3 Fullscreen"
-                enabled: cameraManager.cameraAvailable(3) && fullScreenIndex !== 3
-                onTriggered: fullScreenIndex = 3
-            }
-            MenuItem {
-                text: "Camera 4 Fullscreen"
-                enabled: cameraManager.cameraAvailable(4) && fullScreenIndex !== 4
-                onTriggered: fullScreenIndex = 4
+            Instantiator {
+                id: fullscreenMenuItems
+                model: cameraManager
+                
+                delegate: MenuItem {
+                    text: model.name + " Fullscreen"
+                    enabled: model.available && fullScreenIndex !== model.cameraIndex
+                    onTriggered: fullScreenIndex = model.cameraIndex
+                }
+                
+                onObjectAdded: (index, object) => viewMenu.insertItem(index + 2, object)
+                onObjectRemoved: (index, object) => viewMenu.removeItem(object)
             }
             MenuSeparator {}
             MenuItem {
@@ -1,5 +1,4 @@
 import QtQuick
-import QtQuick.Shapes
 
 Item {
     id: root
@@ -14,7 +13,6 @@ Item {
         if (roiEditMode) {
             // Starting ROI edit - clear any existing temp data
             tempRoiPoints = []
-            canvas.requestPaint()
         }
     }
     
@@ -22,7 +20,6 @@ Item {
         if (tripwireEditMode) {
             // Starting tripwire edit - clear any existing temp data
             tempTripwireStart = null
-            canvas.requestPaint()
         }
     }
     
@@ -59,28 +56,24 @@ Item {
     function loadStoredData() {
         storedRoiPoints = cameraManager.roiPoints(cameraIndex)
         storedTripwire = cameraManager.tripwire(cameraIndex)
-        canvas.requestPaint()
     }
     
     function startRoiEdit() {
         tempRoiPoints = []
         roiEditMode = true
         tripwireEditMode = false
-        canvas.requestPaint()
     }
     
     function startTripwireEdit() {
         tempTripwireStart = null
         tripwireEditMode = true
         roiEditMode = false
-        canvas.requestPaint()
     }
     
     function cancelEdit() {
         // Don't set roiEditMode/tripwireEditMode = false - let parent handle via editingFinished
         tempRoiPoints = []
         tempTripwireStart = null
-        canvas.requestPaint()
         editingFinished()
     }
     
@@ -99,7 +92,6 @@ Item {
         }
         // Don't set roiEditMode = false here - let parent handle it via editingFinished signal
         tempRoiPoints = []
-        canvas.requestPaint()
         editingFinished()
     }
     
@@ -115,7 +107,6 @@ Item {
         }
         // Don't set tripwireEditMode = false here - let parent handle it via editingFinished signal
         tempTripwireStart = null
-        canvas.requestPaint()
         editingFinished()
     }
     
@@ -126,11 +117,8 @@ Item {
         acceptedButtons: Qt.LeftButton | Qt.RightButton
         hoverEnabled: true
         
-        onPositionChanged: {
+        onPositionChanged: (mouse) => {
             root.mousePos = Qt.point(mouse.x, mouse.y)
-            if (tripwireEditMode && tempTripwireStart) {
-                canvas.requestPaint()
-            }
         }
         
         onClicked: (mouse) => {
@@ -142,11 +130,9 @@ Item {
             if (roiEditMode) {
                 tempRoiPoints.push({x: mouse.x, y: mouse.y})
                 tempRoiPoints = tempRoiPoints // Force binding update
-                canvas.requestPaint()
             } else if (tripwireEditMode) {
                 if (!tempTripwireStart) {
                     tempTripwireStart = {x: mouse.x, y: mouse.y}
-                    canvas.requestPaint()
                 } else {
                     root.finishTripwireEdit(mouse.x, mouse.y)
                 }
@@ -160,128 +146,33 @@ Item {
         }
     }
     
-    // Main canvas for all drawing
-    Canvas {
-        id: canvas
+    // Scene-graph overlay: geometry is rebuilt only when a shape changes,
+    // alert highlighting is an opacity pulse on prebuilt layers
+    RoiOverlayItem {
+        id: overlayItem
         anchors.fill: parent
         
-        onPaint: {
-            var ctx = getContext("2d")
-            ctx.clearRect(0, 0, width, height)
-            
-            // Draw stored ROI (when not editing)
-            if (!roiEditMode && storedRoiPoints && storedRoiPoints.length >= 3) {
-                // Use brighter color if ROI alert is active
-                var isAlert = cameraStream && cameraStream.roiAlertActive
-                ctx.fillStyle = isAlert ? "rgba(231, 76, 60, 0.4)" : "rgba(52, 152, 219, 0.3)"
-                ctx.strokeStyle = isAlert ? "#e74c3c" : "#3498db"
-                ctx.lineWidth = isAlert ? 4 : 3
-                ctx.setLineDash([])
-                
-                ctx.beginPath()
-                ctx.moveTo(storedRoiPoints[0].x * width, storedRoiPoints[0].y * height)
-                for (var i = 1; i < storedRoiPoints.length; i++) {
-                    ctx.lineTo(storedRoiPoints[i].x * width, storedRoiPoints[i].y * height)
-                }
-                ctx.closePath()
-                ctx.fill()
-                ctx.stroke()
-            }
-            
-            // Draw editing ROI
-            if (roiEditMode && tempRoiPoints.length > 0) {
-                // Draw points
-                ctx.fillStyle = "#e74c3c"
-                for (var j = 0; j < tempRoiPoints.length; j++) {
-                    ctx.beginPath()
-                    ctx.arc(tempRoiPoints[j].x, tempRoiPoints[j].y, 6, 0, 2 * Math.PI)
-                    ctx.fill()
-                    
-                    // White border
-                    ctx.strokeStyle = "#ffffff"
-                    ctx.lineWidth = 2
-                    ctx.stroke()
-                }
-                
-                // Draw lines between points
-                if (tempRoiPoints.length > 1) {
-                    ctx.strokeStyle = "#e74c3c"
-                    ctx.lineWidth = 2
-                    ctx.setLineDash([5, 3])
-                    
-                    ctx.beginPath()
-                    ctx.moveTo(tempRoiPoints[0].x, tempRoiPoints[0].y)
-                    for (var k = 1; k < tempRoiPoints.length; k++) {
-                        ctx.lineTo(tempRoiPoints[k].x, tempRoiPoints[k].y)
-                    }
-                    // Preview line back to start
-                    ctx.lineTo(tempRoiPoints[0].x, tempRoiPoints[0].y)
-                    ctx.stroke()
-                }
-            }
-            
-            // Draw stored Tripwire (when not editing)
-            if (!tripwireEditMode && storedTripwire && storedTripwire.has) {
-                var startX = storedTripwire.startX * width
-                var startY = storedTripwire.startY * height
-                var endX = storedTripwire.endX * width
-                var endY = storedTripwire.endY * height
-                
-                // Use brighter color if tripwire alert is active
-                var isTripAlert = cameraStream && cameraStream.tripwireAlertActive
-                ctx.strokeStyle = isTripAlert ? "#e74c3c" : "#e67e22"
-                ctx.lineWidth = isTripAlert ? 6 : 4
-                ctx.setLineDash([])
-                
-                ctx.beginPath()
-                ctx.moveTo(startX, startY)
-                ctx.lineTo(endX, endY)
-                ctx.stroke()
-                
-                // Draw endpoints
-                ctx.fillStyle = isTripAlert ? "#e74c3c" : "#e67e22"
-                ctx.beginPath()
-                ctx.arc(startX, startY, isTripAlert ? 8 : 6, 0, 2 * Math.PI)
-                ctx.fill()
-                ctx.beginPath()
-                ctx.arc(endX, endY, isTripAlert ? 8 : 6, 0, 2 * Math.PI)
-                ctx.fill()
-            }
-            
-            // Draw editing Tripwire
-            if (tripwireEditMode && tempTripwireStart) {
-                // Draw start point
-                ctx.fillStyle = "#e74c3c"
-                ctx.beginPath()
-                ctx.arc(tempTripwireStart.x, tempTripwireStart.y, 6, 0, 2 * Math.PI)
-                ctx.fill()
-                
-                ctx.strokeStyle = "#ffffff"
-                ctx.lineWidth = 2
-                ctx.stroke()
-                
-                // Draw preview line to mouse
-                ctx.strokeStyle = "#e74c3c"
-                ctx.lineWidth = 3
-                ctx.setLineDash([5, 3])
-                
-                ctx.beginPath()
-                ctx.moveTo(tempTripwireStart.x, tempTripwireStart.y)
-                ctx.lineTo(root.mousePos.x, root.mousePos.y)
-                ctx.stroke()
-            }
+        roiPoints: storedRoiPoints ? storedRoiPoints : []
+        tripwire: storedTripwire ? storedTripwire : ({})
+        
+        roiEditMode: root.roiEditMode
+        tripwireEditMode: root.tripwireEditMode
+        editPoints: tempRoiPoints
+        hasEditTripwireStart: tempTripwireStart !== null
+        editTripwireStart: tempTripwireStart ? Qt.point(tempTripwireStart.x, tempTripwireStart.y) : Qt.point(0, 0)
+        cursorPos: root.mousePos
+        
+        roiAlertActive: cameraStream ? cameraStream.roiAlertActive : false
+        tripwireAlertActive: cameraStream ? cameraStream.tripwireAlertActive : false
+        
+        SequentialAnimation on alertPulse {
+            running: overlayItem.roiAlertActive || overlayItem.tripwireAlertActive
+            loops: Animation.Infinite
+            NumberAnimation { from: 1.0; to: 0.6; duration: 400 }
+            NumberAnimation { from: 0.6; to: 1.0; duration: 400 }
         }
     }
     
-    // Timer to update overlay when alerts are active
-    Timer {
-        running: (cameraStream && cameraStream.roiAlertActive) || 
-                 (cameraStream && cameraStream.tripwireAlertActive)
-        interval: 100
-        repeat: true
-        onTriggered: canvas.requestPaint()
-    }
-    
     // Help text
     Rectangle {
         anchors.bottom: parent.bottom
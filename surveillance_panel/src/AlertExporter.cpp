@@ -0,0 +1,212 @@
+#include "AlertExporter.h"
+#include <QSaveFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include <limits>
+
+AlertExporter::AlertExporter(const QString &filePath, Format format, const QVector<Alert> &alerts,
+                             QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+    , m_format(format)
+    , m_alerts(alerts)
+    , m_alertsTaken(false)
+    , m_store(nullptr)
+    , m_total(alerts.count())
+    , m_written(0)
+    , m_cancelled(false)
+{
+}
+
+AlertExporter::AlertExporter(const QString &filePath, Format format, AlertStore *store,
+                             QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+    , m_format(format)
+    , m_alertsTaken(true)
+    , m_store(store)
+    , m_total(0)
+    , m_written(0)
+    , m_cancelled(false)
+{
+    m_query.oldestFirst = true;
+    m_query.limit = HISTORY_PAGE_ROWS;
+}
+
+void AlertExporter::run()
+{
+    // Alerts added while the export runs are left out, so the total holds
+    if (m_store) {
+        // Writes queued on the store's thread before the export started land first
+        QMetaObject::invokeMethod(m_store, [] {}, Qt::BlockingQueuedConnection);
+        m_query.beforeSeq = m_store->maxSeq() + 1;
+        m_total = static_cast<int>(qMin<qint64>(m_store->count(), std::numeric_limits<int>::max()));
+    }
+
+    QDir dir = QFileInfo(m_filePath).dir();
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qWarning() << "Failed to create directory:" << dir.path();
+        emit finished(false, "Cannot create directory " + dir.path());
+        return;
+    }
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Failed to open file for writing:" << m_filePath;
+        emit finished(false, file.errorString());
+        return;
+    }
+
+    const bool written = (m_format == Format::Csv) ? writeCsv(&file) : writeJson(&file);
+
+    // Without commit() the target file is left untouched
+    if (isCancelled()) {
+        file.cancelWriting();
+        qDebug() << "Alert export cancelled:" << m_filePath;
+        emit finished(false, "Cancelled");
+        return;
+    }
+
+    if (!written) {
+        file.cancelWriting();
+        qWarning() << "Failed to write export:" << m_filePath << file.errorString();
+        emit finished(false, file.errorString());
+        return;
+    }
+
+    if (!file.commit()) {
+        qWarning() << "Failed to write export:" << m_filePath << file.errorString();
+        emit finished(false, file.errorString());
+        return;
+    }
+
+    qDebug() << "Exported" << m_written << "alerts to" << m_filePath;
+    emit finished(true, QString());
+}
+
+bool AlertExporter::writeCsv(QIODevice *device)
+{
+    QTextStream out(device);
+
+    auto escape = [](const QString &field) -> QString {
+        QString escaped = field;
+        escaped.replace("\"", "\"\"");
+        if (escaped.contains(",") || escaped.contains("\"") || escaped.contains("\n")) {
+            escaped = "\"" + escaped + "\"";
+        }
+        return escaped;
+    };
+
+    out << "ID,Timestamp,Camera Name,Type,Message,Snapshot Path\n";
+
+    QVector<Alert> page;
+    while (nextPage(&page)) {
+        for (const Alert &alert : std::as_const(page)) {
+            if (isCancelled()) {
+                return false;
+            }
+
+            out << escape(alert.id) << ","
+                << escape(alert.timestamp.toString(Qt::ISODate)) << ","
+                << escape(alert.cameraName) << ","
+                << escape(alert.type) << ","
+                << escape(alert.message) << ","
+                << escape(alert.snapshotPath) << "\n";
+
+            reportProgress(++m_written);
+        }
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+bool AlertExporter::writeJson(QIODevice *device)
+{
+    // Same document as before, written one alert object at a time
+    if (device->write("{\n    \"alerts\": [\n") < 0) {
+        return false;
+    }
+
+    QVector<Alert> page;
+    while (nextPage(&page)) {
+        for (const Alert &alert : std::as_const(page)) {
+            if (isCancelled()) {
+                return false;
+            }
+
+            QJsonObject alertObj;
+            alertObj["id"] = alert.id;
+            alertObj["timestamp"] = alert.timestamp.toString(Qt::ISODate);
+            alertObj["cameraName"] = alert.cameraName;
+            alertObj["type"] = alert.type;
+            alertObj["message"] = alert.message;
+            alertObj["snapshotPath"] = alert.snapshotPath;
+            alertObj["hasImage"] = alert.hasStoredSnapshot;
+            if (!alert.clipPath.isEmpty()) {
+                alertObj["clipPath"] = alert.clipPath;
+            }
+            alertObj["repeatCount"] = alert.repeatCount;
+            if (alert.repeatCount > 1) {
+                alertObj["lastTimestamp"] = alert.lastTimestamp.toString(Qt::ISODate);
+            }
+
+            // The separator goes before the entry: the last row is only known at the end
+            QByteArray entry = m_written > 0 ? ",\n        " : "        ";
+            entry += QJsonDocument(alertObj).toJson(QJsonDocument::Compact);
+
+            if (device->write(entry) < 0) {
+                return false;
+            }
+
+            reportProgress(++m_written);
+        }
+    }
+
+    if (m_written > 0 && device->write("\n") < 0) {
+        return false;
+    }
+
+    const QByteArray footer = QString("    ],\n"
+                                      "    \"exportTime\": \"%1\",\n"
+                                      "    \"totalCount\": %2\n"
+                                      "}\n")
+        .arg(QDateTime::currentDateTime().toString(Qt::ISODate))
+        .arg(m_written)
+        .toUtf8();
+
+    return device->write(footer) >= 0;
+}
+
+void AlertExporter::reportProgress(int written)
+{
+    // Rows purged meanwhile can make the history total a little high
+    if (written % PROGRESS_INTERVAL_ROWS == 0 || written == m_total) {
+        emit progressChanged(written, qMax(m_total, written));
+    }
+}
+
+bool AlertExporter::nextPage(QVector<Alert> *page)
+{
+    if (!m_store) {
+        // The rows given up front are the only page
+        if (m_alertsTaken) {
+            return false;
+        }
+        m_alertsTaken = true;
+        *page = m_alerts;
+        return !page->isEmpty();
+    }
+
+    // Keyed on seq, so pages neither skip nor repeat rows while alerts change
+    *page = m_store->query(m_query);
+    if (page->isEmpty()) {
+        return false;
+    }
+    m_query.afterSeq = page->last().seq;
+    return true;
+}
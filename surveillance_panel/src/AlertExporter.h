@@ -0,0 +1,71 @@
+#ifndef ALERTEXPORTER_H
+#define ALERTEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "AlertLogModel.h"
+#include "AlertStore.h"
+
+class QIODevice;
+
+/**
+ * @brief Writes alert rows to a CSV or JSON file on a worker thread
+ *
+ * Works either on a copy of the rows taken on the GUI thread, without
+ * snapshot images, or on the whole alert history, which it reads from the
+ * store page by page, oldest first. Each row is written as it goes rather
+ * than building the whole document in memory. The target file is only
+ * replaced once the export completes, so a cancelled or failed export
+ * leaves no partial file.
+ */
+class AlertExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Format { Csv, Json };
+
+    AlertExporter(const QString &filePath, Format format, const QVector<Alert> &alerts,
+                  QObject *parent = nullptr);
+
+    // Exports every alert in the history as of the start of the export;
+    // the store must outlive the exporter
+    AlertExporter(const QString &filePath, Format format, AlertStore *store,
+                  QObject *parent = nullptr);
+
+    // Thread safe; the export stops at the next row
+    void cancel() { m_cancelled.store(true, std::memory_order_release); }
+
+public slots:
+    void run();
+
+signals:
+    void progressChanged(int written, int total);
+    void finished(bool success, const QString &error);
+
+private:
+    bool writeCsv(QIODevice *device);
+    bool writeJson(QIODevice *device);
+    bool isCancelled() const { return m_cancelled.load(std::memory_order_acquire); }
+    void reportProgress(int written);
+
+    // The next rows to write; false once there are none left
+    bool nextPage(QVector<Alert> *page);
+
+    QString m_filePath;
+    Format m_format;
+    QVector<Alert> m_alerts;
+    bool m_alertsTaken;
+    AlertStore *m_store;                  // Only read, apart from waiting on its thread
+    AlertQuery m_query;         // Next history page
+    int m_total;
+    int m_written;
+    std::atomic<bool> m_cancelled;
+
+    static constexpr int PROGRESS_INTERVAL_ROWS = 500;
+    static constexpr int HISTORY_PAGE_ROWS = 500;
+};
+
+#endif // ALERTEXPORTER_H
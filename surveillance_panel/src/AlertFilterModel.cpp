@@ -0,0 +1,506 @@
+#include "AlertFilterModel.h"
+#include <QSet>
+#include <algorithm>
+
+namespace {
+// Adds seq to the ascending list of key; returns true if the key is new
+bool insertSeq(QHash<QString, QVector<qint64>> &index, const QString &key, qint64 seq)
+{
+    auto it = index.find(key);
+    const bool keyAdded = (it == index.end());
+    if (keyAdded) {
+        it = index.insert(key, QVector<qint64>());
+    }
+
+    // New alerts have the highest sequence number; only paged-in history
+    // lands in front
+    QVector<qint64> &seqs = it.value();
+    if (seqs.isEmpty() || seqs.last() < seq) {
+        seqs.append(seq);
+    } else {
+        seqs.insert(std::lower_bound(seqs.begin(), seqs.end(), seq) - seqs.begin(), seq);
+    }
+
+    return keyAdded;
+}
+
+// Removes the given seqs per key; returns true if a key became empty
+bool removeSeqs(QHash<QString, QVector<qint64>> &index, const QHash<QString, QSet<qint64>> &removed)
+{
+    bool keyRemoved = false;
+
+    for (auto it = removed.cbegin(); it != removed.cend(); ++it) {
+        auto entry = index.find(it.key());
+        if (entry == index.end()) {
+            continue;
+        }
+
+        const QSet<qint64> &gone = it.value();
+        QVector<qint64> &seqs = entry.value();
+        seqs.erase(std::remove_if(seqs.begin(), seqs.end(),
+                                  [&gone](qint64 seq) { return gone.contains(seq); }),
+                   seqs.end());
+
+        if (seqs.isEmpty()) {
+            index.erase(entry);
+            keyRemoved = true;
+        }
+    }
+
+    return keyRemoved;
+}
+}
+
+AlertFilterModel::AlertFilterModel(QObject *parent)
+    : QAbstractProxyModel(parent)
+    , m_alertLog(nullptr)
+    , m_removeFirst(0)
+    , m_removeLast(-1)
+{
+}
+
+void AlertFilterModel::setAlertLogModel(AlertLogModel *alertLog)
+{
+    if (m_alertLog == alertLog) {
+        return;
+    }
+
+    beginResetModel();
+
+    if (m_alertLog) {
+        disconnect(m_alertLog, nullptr, this, nullptr);
+    }
+
+    m_alertLog = alertLog;
+    QAbstractProxyModel::setSourceModel(alertLog);
+
+    if (m_alertLog) {
+        connect(m_alertLog, &QAbstractItemModel::modelAboutToBeReset,
+                this, &AlertFilterModel::onSourceAboutToBeReset);
+        connect(m_alertLog, &QAbstractItemModel::modelReset,
+                this, &AlertFilterModel::onSourceReset);
+        connect(m_alertLog, &QAbstractItemModel::rowsInserted,
+                this, &AlertFilterModel::onRowsInserted);
+        connect(m_alertLog, &QAbstractItemModel::rowsAboutToBeRemoved,
+                this, &AlertFilterModel::onRowsAboutToBeRemoved);
+        connect(m_alertLog, &QAbstractItemModel::rowsRemoved,
+                this, &AlertFilterModel::onRowsRemoved);
+        connect(m_alertLog, &QAbstractItemModel::dataChanged,
+                this, &AlertFilterModel::onDataChanged);
+    }
+
+    rebuildIndexes();
+    m_sourceRows = matchingRows();
+
+    endResetModel();
+
+    emit alertLogModelChanged();
+    emit countChanged();
+    emit keysChanged();
+}
+
+void AlertFilterModel::setCameraFilter(const QString &cameraName)
+{
+    if (m_cameraFilter == cameraName) {
+        return;
+    }
+
+    m_cameraFilter = cameraName;
+    refilter();
+}
+
+void AlertFilterModel::setTypeFilter(const QString &type)
+{
+    if (m_typeFilter == type) {
+        return;
+    }
+
+    m_typeFilter = type;
+    refilter();
+}
+
+void AlertFilterModel::setTextFilter(const QString &text)
+{
+    if (m_textFilter == text) {
+        return;
+    }
+
+    m_textFilter = text;
+    refilter();
+}
+
+void AlertFilterModel::setSince(const QDateTime &since)
+{
+    if (m_since == since) {
+        return;
+    }
+
+    m_since = since;
+    refilter();
+}
+
+void AlertFilterModel::setUntil(const QDateTime &until)
+{
+    if (m_until == until) {
+        return;
+    }
+
+    m_until = until;
+    refilter();
+}
+
+void AlertFilterModel::clearFilters()
+{
+    m_cameraFilter.clear();
+    m_typeFilter.clear();
+    m_textFilter.clear();
+    m_since = QDateTime();
+    m_until = QDateTime();
+    refilter();
+}
+
+QStringList AlertFilterModel::cameraNames() const
+{
+    QStringList names = m_seqsByCamera.keys();
+    names.sort();
+    return names;
+}
+
+QStringList AlertFilterModel::types() const
+{
+    QStringList names = m_seqsByType.keys();
+    names.sort();
+    return names;
+}
+
+int AlertFilterModel::sourceRow(int row) const
+{
+    return (row >= 0 && row < m_sourceRows.count()) ? m_sourceRows.at(row) : -1;
+}
+
+QVariantList AlertFilterModel::sourceRows(const QVariantList &rows) const
+{
+    QVariantList result;
+    result.reserve(rows.count());
+
+    for (const QVariant &var : rows) {
+        const int row = sourceRow(var.toInt());
+        if (row >= 0) {
+            result.append(row);
+        }
+    }
+
+    return result;
+}
+
+QModelIndex AlertFilterModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!m_alertLog || !proxyIndex.isValid() || proxyIndex.row() >= m_sourceRows.count()) {
+        return QModelIndex();
+    }
+
+    return m_alertLog->index(m_sourceRows.at(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex AlertFilterModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid()) {
+        return QModelIndex();
+    }
+
+    auto it = std::lower_bound(m_sourceRows.cbegin(), m_sourceRows.cend(), sourceIndex.row());
+    if (it == m_sourceRows.cend() || *it != sourceIndex.row()) {
+        return QModelIndex();
+    }
+
+    return createIndex(static_cast<int>(it - m_sourceRows.cbegin()), sourceIndex.column());
+}
+
+QModelIndex AlertFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= m_sourceRows.count() || column != 0) {
+        return QModelIndex();
+    }
+
+    return createIndex(row, column);
+}
+
+QModelIndex AlertFilterModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+int AlertFilterModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_sourceRows.count();
+}
+
+int AlertFilterModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+void AlertFilterModel::onSourceAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void AlertFilterModel::onSourceReset()
+{
+    rebuildIndexes();
+    m_sourceRows = matchingRows();
+    endResetModel();
+
+    emit countChanged();
+    emit keysChanged();
+}
+
+void AlertFilterModel::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+
+    const bool keysAdded = indexRows(first, last);
+
+    // Accepted rows behind the insertion point moved down
+    const int inserted = last - first + 1;
+    const int pos = static_cast<int>(
+        std::lower_bound(m_sourceRows.cbegin(), m_sourceRows.cend(), first) - m_sourceRows.cbegin());
+    for (int i = pos; i < m_sourceRows.count(); ++i) {
+        m_sourceRows[i] += inserted;
+    }
+
+    QVector<int> accepted;
+    for (int row = first; row <= last; ++row) {
+        if (acceptsRow(row)) {
+            accepted.append(row);
+        }
+    }
+
+    if (!accepted.isEmpty()) {
+        beginInsertRows(QModelIndex(), pos, pos + accepted.count() - 1);
+        if (pos == m_sourceRows.count()) {
+            m_sourceRows.append(accepted);
+        } else {
+            m_sourceRows = m_sourceRows.mid(0, pos) + accepted + m_sourceRows.mid(pos);
+        }
+        endInsertRows();
+        emit countChanged();
+    }
+
+    if (keysAdded) {
+        emit keysChanged();
+    }
+}
+
+void AlertFilterModel::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+
+    // The rows are still readable here, so this is where they leave the indexes
+    if (unindexRows(first, last)) {
+        emit keysChanged();
+    }
+
+    m_removeFirst = static_cast<int>(
+        std::lower_bound(m_sourceRows.cbegin(), m_sourceRows.cend(), first) - m_sourceRows.cbegin());
+    m_removeLast = static_cast<int>(
+        std::upper_bound(m_sourceRows.cbegin(), m_sourceRows.cend(), last) - m_sourceRows.cbegin()) - 1;
+
+    if (m_removeLast >= m_removeFirst) {
+        beginRemoveRows(QModelIndex(), m_removeFirst, m_removeLast);
+    }
+}
+
+void AlertFilterModel::onRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+
+    const bool removing = (m_removeLast >= m_removeFirst);
+    if (removing) {
+        m_sourceRows.remove(m_removeFirst, m_removeLast - m_removeFirst + 1);
+    }
+
+    // Accepted rows behind the removed range moved up
+    const int removed = last - first + 1;
+    for (int i = m_removeFirst; i < m_sourceRows.count(); ++i) {
+        m_sourceRows[i] -= removed;
+    }
+
+    if (removing) {
+        endRemoveRows();
+        emit countChanged();
+    }
+
+    m_removeFirst = 0;
+    m_removeLast = -1;
+}
+
+void AlertFilterModel::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                                     const QList<int> &roles)
+{
+    // Only repeat counts change in place, and no filter looks at them
+    const int lo = static_cast<int>(
+        std::lower_bound(m_sourceRows.cbegin(), m_sourceRows.cend(), topLeft.row()) - m_sourceRows.cbegin());
+    const int hi = static_cast<int>(
+        std::upper_bound(m_sourceRows.cbegin(), m_sourceRows.cend(), bottomRight.row()) - m_sourceRows.cbegin());
+
+    if (hi > lo) {
+        emit dataChanged(index(lo, 0), index(hi - 1, 0), roles);
+    }
+}
+
+void AlertFilterModel::rebuildIndexes()
+{
+    m_seqsByType.clear();
+    m_seqsByCamera.clear();
+
+    if (m_alertLog && m_alertLog->rowCount() > 0) {
+        indexRows(0, m_alertLog->rowCount() - 1);
+    }
+}
+
+bool AlertFilterModel::indexRows(int first, int last)
+{
+    bool keysAdded = false;
+
+    for (int row = first; row <= last; ++row) {
+        const Alert &alert = m_alertLog->alertAt(row);
+        keysAdded |= insertSeq(m_seqsByType, alert.type, alert.seq);
+        keysAdded |= insertSeq(m_seqsByCamera, alert.cameraName, alert.seq);
+    }
+
+    return keysAdded;
+}
+
+bool AlertFilterModel::unindexRows(int first, int last)
+{
+    // Grouped per key so each list is compacted once per removal
+    QHash<QString, QSet<qint64>> typeSeqs;
+    QHash<QString, QSet<qint64>> cameraSeqs;
+
+    for (int row = first; row <= last; ++row) {
+        const Alert &alert = m_alertLog->alertAt(row);
+        typeSeqs[alert.type].insert(alert.seq);
+        cameraSeqs[alert.cameraName].insert(alert.seq);
+    }
+
+    const bool typesRemoved = removeSeqs(m_seqsByType, typeSeqs);
+    const bool camerasRemoved = removeSeqs(m_seqsByCamera, cameraSeqs);
+    return typesRemoved || camerasRemoved;
+}
+
+void AlertFilterModel::refilter()
+{
+    beginResetModel();
+    m_sourceRows = matchingRows();
+    endResetModel();
+
+    emit filterChanged();
+    emit countChanged();
+}
+
+QVector<int> AlertFilterModel::matchingRows() const
+{
+    QVector<int> rows;
+    if (!m_alertLog) {
+        return rows;
+    }
+
+    // The log is in time order, so the time range is a span of rows
+    const int lo = m_since.isValid() ? lowerBoundRow(m_since) : 0;
+    const int hi = m_until.isValid() ? lowerBoundRow(m_until) : m_alertLog->rowCount();
+    if (lo >= hi) {
+        return rows;
+    }
+
+    // Walk the smaller of the selected type and camera lists
+    const QVector<qint64> *candidates = nullptr;
+
+    if (!m_typeFilter.isEmpty()) {
+        auto it = m_seqsByType.constFind(m_typeFilter);
+        if (it == m_seqsByType.constEnd()) {
+            return rows;
+        }
+        candidates = &it.value();
+    }
+
+    if (!m_cameraFilter.isEmpty()) {
+        auto it = m_seqsByCamera.constFind(m_cameraFilter);
+        if (it == m_seqsByCamera.constEnd()) {
+            return rows;
+        }
+        if (!candidates || it.value().count() < candidates->count()) {
+            candidates = &it.value();
+        }
+    }
+
+    if (!candidates) {
+        rows.reserve(hi - lo);
+        for (int row = lo; row < hi; ++row) {
+            if (matchesText(m_alertLog->alertAt(row))) {
+                rows.append(row);
+            }
+        }
+        return rows;
+    }
+
+    // Sequence numbers ascend with the rows, so the time span is a sub-range of the list
+    auto begin = std::lower_bound(candidates->cbegin(), candidates->cend(), m_alertLog->alertAt(lo).seq);
+    auto end = std::upper_bound(begin, candidates->cend(), m_alertLog->alertAt(hi - 1).seq);
+
+    for (auto it = begin; it != end; ++it) {
+        const int row = m_alertLog->rowForSeq(*it);
+        if (row < 0) {
+            continue;
+        }
+
+        // With both filters set, the other one is a single compare
+        const Alert &alert = m_alertLog->alertAt(row);
+        if ((!m_typeFilter.isEmpty() && alert.type != m_typeFilter) ||
+            (!m_cameraFilter.isEmpty() && alert.cameraName != m_cameraFilter) ||
+            !matchesText(alert)) {
+            continue;
+        }
+
+        rows.append(row);
+    }
+
+    return rows;
+}
+
+bool AlertFilterModel::acceptsRow(int sourceRow) const
+{
+    const Alert &alert = m_alertLog->alertAt(sourceRow);
+
+    return (m_typeFilter.isEmpty() || alert.type == m_typeFilter)
+        && (m_cameraFilter.isEmpty() || alert.cameraName == m_cameraFilter)
+        && (!m_since.isValid() || alert.timestamp >= m_since)
+        && (!m_until.isValid() || alert.timestamp < m_until)
+        && matchesText(alert);
+}
+
+bool AlertFilterModel::matchesText(const Alert &alert) const
+{
+    return m_textFilter.isEmpty()
+        || alert.message.contains(m_textFilter, Qt::CaseInsensitive)
+        || alert.cameraName.contains(m_textFilter, Qt::CaseInsensitive);
+}
+
+int AlertFilterModel::lowerBoundRow(const QDateTime &time) const
+{
+    // First row at or after time
+    int lo = 0;
+    int hi = m_alertLog->rowCount();
+
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (m_alertLog->alertAt(mid).timestamp < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
@@ -0,0 +1,119 @@
+#ifndef ALERTFILTERMODEL_H
+#define ALERTFILTERMODEL_H
+
+#include <QAbstractProxyModel>
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QtQml/qqmlregistration.h>
+#include "AlertLogModel.h"
+
+/**
+ * @brief Filtered view of the alert log by camera, type, time range and text
+ *
+ * Keeps per-type and per-camera lists of alert sequence numbers, updated as
+ * rows are added and removed, so changing a filter only visits the rows of
+ * the selected type or camera instead of comparing strings on every alert.
+ * The time range is found by binary search, since the log is in time order.
+ * Only the text filter is checked row by row, and only on those candidates.
+ *
+ * Row order is the order of the alert log. Functions of the log that take
+ * row indices expect source rows; use sourceRow()/sourceRows() to map.
+ */
+class AlertFilterModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(AlertLogModel *alertLogModel READ alertLogModel WRITE setAlertLogModel NOTIFY alertLogModelChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(QString cameraFilter READ cameraFilter WRITE setCameraFilter NOTIFY filterChanged)
+    Q_PROPERTY(QString typeFilter READ typeFilter WRITE setTypeFilter NOTIFY filterChanged)
+    Q_PROPERTY(QString textFilter READ textFilter WRITE setTextFilter NOTIFY filterChanged)
+    Q_PROPERTY(QDateTime since READ since WRITE setSince NOTIFY filterChanged)
+    Q_PROPERTY(QDateTime until READ until WRITE setUntil NOTIFY filterChanged)
+    Q_PROPERTY(QStringList cameraNames READ cameraNames NOTIFY keysChanged)
+    Q_PROPERTY(QStringList types READ types NOTIFY keysChanged)
+
+public:
+    explicit AlertFilterModel(QObject *parent = nullptr);
+
+    AlertLogModel *alertLogModel() const { return m_alertLog; }
+    void setAlertLogModel(AlertLogModel *alertLog);
+
+    // Empty strings and invalid times do not filter
+    QString cameraFilter() const { return m_cameraFilter; }
+    void setCameraFilter(const QString &cameraName);
+    QString typeFilter() const { return m_typeFilter; }
+    void setTypeFilter(const QString &type);
+    QString textFilter() const { return m_textFilter; }
+    void setTextFilter(const QString &text);
+    QDateTime since() const { return m_since; }
+    void setSince(const QDateTime &since);
+    QDateTime until() const { return m_until; }
+    void setUntil(const QDateTime &until);
+
+    // Values present in the log, for filter choices
+    QStringList cameraNames() const;
+    QStringList types() const;
+
+    int count() const { return m_sourceRows.count(); }
+
+    Q_INVOKABLE int sourceRow(int row) const;
+    Q_INVOKABLE QVariantList sourceRows(const QVariantList &rows) const;
+    Q_INVOKABLE void clearFilters();
+
+    // QAbstractProxyModel interface
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+signals:
+    void alertLogModelChanged();
+    void countChanged();
+    void filterChanged();
+    void keysChanged();
+
+private:
+    // Source model notifications
+    void onSourceAboutToBeReset();
+    void onSourceReset();
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles);
+
+    // Indexes
+    void rebuildIndexes();
+    bool indexRows(int first, int last);
+    bool unindexRows(int first, int last);
+
+    // Filtering
+    void refilter();
+    QVector<int> matchingRows() const;
+    bool acceptsRow(int sourceRow) const;
+    bool matchesText(const Alert &alert) const;
+    int lowerBoundRow(const QDateTime &time) const;
+
+    AlertLogModel *m_alertLog;
+
+    QVector<int> m_sourceRows;                       // Accepted source rows, ascending
+    QHash<QString, QVector<qint64>> m_seqsByType;    // Ascending sequence numbers per key
+    QHash<QString, QVector<qint64>> m_seqsByCamera;
+
+    QString m_cameraFilter;
+    QString m_typeFilter;
+    QString m_textFilter;
+    QDateTime m_since;
+    QDateTime m_until;
+
+    // Proxy rows announced in onRowsAboutToBeRemoved, removed in onRowsRemoved
+    int m_removeFirst;
+    int m_removeLast;
+};
+
+#endif // ALERTFILTERMODEL_H
@@ -1,15 +1,235 @@
 #include "AlertLogModel.h"
 #include <QFile>
-#include <QTextStream>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
 #include <QDir>
+#include <QThread>
+#include <QTimer>
 #include <QDebug>
+#include <algorithm>
+#include <limits>
+#include "AlertStore.h"
+#include "AlertExporter.h"
 
 AlertLogModel::AlertLogModel(QObject *parent)
     : QAbstractListModel(parent)
+    , m_maxAlerts(DEFAULT_MAX_ALERTS)
+    , m_maxSnapshotBytes(DEFAULT_MAX_SNAPSHOT_BYTES)
+    , m_snapshotBytes(0)
+    , m_storeThread(new QThread(this))
+    , m_store(new AlertStore())
+    , m_storeOpen(false)
+    , m_nextSeq(1)
+    , m_olderCount(0)
+    , m_positionBase(0)
+    , m_ingestTimer(new QTimer(this))
+    , m_exportThread(nullptr)
+    , m_exporter(nullptr)
+    , m_exportProgress(0.0)
+    , m_publishPending(false)
+    , m_publishedRevision(0)
+    , m_publishedSnapshotBytes(0)
 {
+    // All history writes happen on the store's own thread
+    m_storeThread->setObjectName("AlertStore");
+    m_store->moveToThread(m_storeThread);
+    connect(m_storeThread, &QThread::finished, m_store, &QObject::deleteLater);
+    connect(m_store, &AlertStore::expiredPurged, this, &AlertLogModel::onExpiredPurged);
+    m_storeThread->start();
+    
+    m_ingestTimer->setSingleShot(true);
+    m_ingestTimer->setInterval(INGEST_INTERVAL_MS);
+    connect(m_ingestTimer, &QTimer::timeout, this, &AlertLogModel::flushPendingAlerts);
+    
+    // Every change to the rows shows up in one of these
+    connect(this, &QAbstractItemModel::rowsInserted, this, &AlertLogModel::schedulePublish);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, &AlertLogModel::schedulePublish);
+    connect(this, &QAbstractItemModel::modelReset, this, &AlertLogModel::schedulePublish);
+    connect(this, &QAbstractItemModel::dataChanged, this, &AlertLogModel::schedulePublish);
+    connect(this, &AlertLogModel::snapshotBytesChanged, this, &AlertLogModel::schedulePublish);
+}
+
+AlertLogModel::~AlertLogModel()
+{
+    if (m_exporter) {
+        m_exporter->cancel();
+        m_exportThread->quit();
+        m_exportThread->wait();
+    }
+    
+    // Alerts and repeats still waiting for the next batch go to the history directly
+    QVector<Alert> repeated;
+    for (qint64 seq : std::as_const(m_repeatedSeqs)) {
+        const int row = rowForSeq(seq);
+        if (row >= 0) {
+            repeated.append(m_alerts.at(row));
+        }
+    }
+    persistRepeats(repeated);
+    persistAlerts(m_pendingAlerts);
+    
+    // Queued writes are processed before the thread's event loop exits
+    m_storeThread->quit();
+    m_storeThread->wait();
+}
+
+void AlertLogModel::setStorageDirectory(const QString &dirPath)
+{
+    const QString databasePath = QDir(dirPath).filePath("alerts.db");
+    
+    bool opened = false;
+    AlertStore *store = m_store;
+    QMetaObject::invokeMethod(m_store, [store, databasePath]() {
+        return store->open(databasePath);
+    }, Qt::BlockingQueuedConnection, &opened);
+    
+    m_storeOpen = opened;
+    if (!m_storeOpen) {
+        qWarning() << "Alert history disabled, alerts are kept in memory only";
+        return;
+    }
+    
+    // Continue the sequence and show the newest part of the history
+    m_nextSeq = qMax(m_nextSeq, m_store->maxSeq() + 1);
+    
+    AlertQuery query;
+    query.limit = qMin(m_maxAlerts, INITIAL_LOAD_COUNT);
+    QVector<Alert> recent = m_store->query(query);
+    std::reverse(recent.begin(), recent.end());  // Oldest first, like the rows
+    
+    const int storedCount = static_cast<int>(qMin<qint64>(m_store->count(), std::numeric_limits<int>::max()));
+    
+    beginResetModel();
+    m_alerts = recent;
+    rebuildIndex();
+    endResetModel();
+    
+    const bool hadOlder = hasOlderAlerts();
+    m_olderCount = qMax(0, storedCount - m_alerts.count());
+    
+    emit countChanged();
+    if (hadOlder != hasOlderAlerts()) {
+        emit hasOlderAlertsChanged();
+    }
+    
+    qDebug() << "Loaded" << m_alerts.count() << "of" << storedCount << "alerts from history";
+}
+
+int AlertLogModel::rowForId(const QString &id) const
+{
+    bool ok;
+    const qint64 seq = id.toLongLong(&ok);
+    return ok ? rowForSeq(seq) : -1;
+}
+
+int AlertLogModel::rowForSeq(qint64 seq) const
+{
+    auto it = m_positionBySeq.constFind(seq);
+    if (it == m_positionBySeq.constEnd()) {
+        return -1;
+    }
+    
+    return static_cast<int>(it.value() - m_positionBase);
+}
+
+QVector<Alert> AlertLogModel::alertsSnapshot() const
+{
+    QMutexLocker locker(&m_snapshotMutex);
+    return m_snapshot;
+}
+
+bool AlertLogModel::findAlert(const QString &id, Alert *alert) const
+{
+    bool ok;
+    const qint64 seq = id.toLongLong(&ok);
+    if (!ok) {
+        return false;
+    }
+    
+    // The model's own thread sees the rows as they are right now
+    if (QThread::currentThread() == thread()) {
+        const int row = rowForSeq(seq);
+        if (row >= 0) {
+            if (alert) {
+                *alert = m_alerts.at(row);
+            }
+            return true;
+        }
+    }
+    
+    // Rows are in sequence order
+    const QVector<Alert> rows = alertsSnapshot();
+    auto it = std::lower_bound(rows.cbegin(), rows.cend(), seq,
+                               [](const Alert &row, qint64 value) { return row.seq < value; });
+    if (it != rows.cend() && it->seq == seq) {
+        if (alert) {
+            *alert = *it;
+        }
+        return true;
+    }
+    
+    // Not in memory: a primary key lookup in the history
+    if (!m_storeOpen) {
+        return false;
+    }
+    
+    return m_store->findAlert(seq, alert);
+}
+
+QVector<Alert> AlertLogModel::queryAlerts(const AlertQuery &query) const
+{
+    if (m_storeOpen) {
+        return m_store->query(query);
+    }
+    
+    const QVector<Alert> rows = alertsSnapshot();
+    
+    QVector<Alert> result;
+    const int count = rows.count();
+    for (int n = 0; n < count && result.count() < query.limit; ++n) {
+        const Alert &alert = rows.at(query.oldestFirst ? n : count - 1 - n);
+        
+        if ((query.since.isValid() && alert.timestamp < query.since) ||
+            (query.until.isValid() && alert.timestamp >= query.until) ||
+            (!query.cameraName.isEmpty() && alert.cameraName != query.cameraName) ||
+            (!query.type.isEmpty() && alert.type != query.type) ||
+            (query.beforeSeq >= 0 && alert.seq >= query.beforeSeq) ||
+            (query.afterSeq >= 0 && alert.seq <= query.afterSeq)) {
+            continue;
+        }
+        
+        Alert copy = alert;
+        copy.hasStoredSnapshot = hasSnapshot(alert);
+        result.append(copy);
+    }
+    
+    return result;
+}
+
+void AlertLogModel::setMaxAlerts(int maxAlerts)
+{
+    maxAlerts = qMax(1, maxAlerts);
+    
+    if (m_maxAlerts == maxAlerts) {
+        return;
+    }
+    
+    m_maxAlerts = maxAlerts;
+    emit maxAlertsChanged();
+    
+    enforceAlertLimit();
+}
+
+void AlertLogModel::setMaxSnapshotBytes(qint64 bytes)
+{
+    bytes = qMax<qint64>(0, bytes);
+    
+    if (m_maxSnapshotBytes == bytes) {
+        return;
+    }
+    
+    m_maxSnapshotBytes = bytes;
+    emit maxSnapshotBytesChanged();
+    
+    enforceSnapshotBudget();
 }
 
 int AlertLogModel::rowCount(const QModelIndex &parent) const
@@ -40,7 +260,15 @@ QVariant AlertLogModel::data(const QModelIndex &index, int role) const
     case SnapshotPathRole:
         return alert.snapshotPath;
     case HasImageRole:
-        return !alert.snapshotImage.isNull();
+        return hasSnapshot(alert);
+    case RepeatCountRole:
+        return alert.repeatCount;
+    case LastTimestampRole:
+        return alert.lastTimestamp.isValid() ? alert.lastTimestamp : alert.timestamp;
+    case HasThumbnailRole:
+        return !alert.snapshotThumbnailJpeg.isEmpty() || alert.hasStoredSnapshot;
+    case ClipPathRole:
+        return alert.clipPath;
     default:
         return QVariant();
     }
@@ -56,13 +284,16 @@ QHash<int, QByteArray> AlertLogModel::roleNames() const
     roles[MessageRole] = "message";
     roles[SnapshotPathRole] = "snapshotPath";
     roles[HasImageRole] = "hasImage";
+    roles[RepeatCountRole] = "repeatCount";
+    roles[LastTimestampRole] = "lastTimestamp";
+    roles[HasThumbnailRole] = "hasThumbnail";
+    roles[ClipPathRole] = "clipPath";
     return roles;
 }
 
 void AlertLogModel::addSnapshotAlert(const QString &cameraName, const QImage &image)
 {
     Alert alert;
-    alert.id = generateId();
     alert.timestamp = QDateTime::currentDateTime();
     alert.cameraName = cameraName;
     alert.type = "snapshot";
@@ -75,30 +306,32 @@ void AlertLogModel::addSnapshotAlert(const QString &cameraName, const QImage &im
 
 void AlertLogModel::addMotionAlert(const QString &cameraName, 
                                    const QString &message,
-                                   const QString &snapshotPath)
+                                   const QString &snapshotPath,
+                                   const QString &clipPath)
 {
     Alert alert;
-    alert.id = generateId();
     alert.timestamp = QDateTime::currentDateTime();
     alert.cameraName = cameraName;
     alert.type = "motion";
     alert.message = message.isEmpty() ? "Motion detected" : message;
     alert.snapshotPath = snapshotPath;
+    alert.pendingClipPath = clipPath;
 
     addAlert(alert);
 }
 
 void AlertLogModel::addRoiMotionAlert(const QString &cameraName,
                                        const QString &message,
-                                       const QString &snapshotPath)
+                                       const QString &snapshotPath,
+                                       const QString &clipPath)
 {
     Alert alert;
-    alert.id = generateId();
     alert.timestamp = QDateTime::currentDateTime();
     alert.cameraName = cameraName;
     alert.type = "motion_roi";
     alert.message = message.isEmpty() ? "Motion in ROI" : message;
     alert.snapshotPath = snapshotPath;
+    alert.pendingClipPath = clipPath;
 
     addAlert(alert);
 }
@@ -106,45 +339,79 @@ void AlertLogModel::addRoiMotionAlert(const QString &cameraName,
 void AlertLogModel::addTripwireAlert(const QString &cameraName,
                                       const QString &message,
                                       const QString &snapshotPath,
-                                      int direction)
+                                      int direction,
+                                      int trackId,
+                                      const QString &clipPath)
 {
     Q_UNUSED(direction);
     
     Alert alert;
-    alert.id = generateId();
     alert.timestamp = QDateTime::currentDateTime();
     alert.cameraName = cameraName;
     alert.type = "tripwire";
     alert.message = message.isEmpty() ? "Tripwire crossed" : message;
     alert.snapshotPath = snapshotPath;
+    alert.trackId = trackId;
+    alert.pendingClipPath = clipPath;
 
     addAlert(alert);
 }
 
 void AlertLogModel::addLoiteringAlert(const QString &cameraName,
                                        const QString &message,
-                                       const QString &snapshotPath)
+                                       const QString &snapshotPath,
+                                       int trackId,
+                                       const QString &clipPath)
 {
     Alert alert;
-    alert.id = generateId();
     alert.timestamp = QDateTime::currentDateTime();
     alert.cameraName = cameraName;
     alert.type = "loitering";
     alert.message = message.isEmpty() ? "Loitering detected" : message;
     alert.snapshotPath = snapshotPath;
+    alert.trackId = trackId;
+    alert.pendingClipPath = clipPath;
 
     addAlert(alert);
 }
 
 void AlertLogModel::clear()
 {
-    if (m_alerts.isEmpty()) {
+    // Queued alerts are part of the log too
+    m_ingestTimer->stop();
+    QVector<Alert> removed = m_pendingAlerts;
+    m_pendingAlerts.clear();
+    m_repeatedSeqs.clear();
+    m_lastSeqByKey.clear();
+    
+    if (m_alerts.isEmpty() && m_olderCount == 0) {
         return;
     }
 
     beginResetModel();
+    for (const Alert &alert : m_alerts) {
+        releaseSnapshot(alert);
+    }
+    removed.append(m_alerts);
     m_alerts.clear();
+    rebuildIndex();
     endResetModel();
+    
+    releaseClips(removed);
+    
+    // Clearing the log also clears the persistent history
+    if (m_storeOpen) {
+        AlertStore *store = m_store;
+        QMetaObject::invokeMethod(m_store, [store]() {
+            store->removeAll();
+        }, Qt::QueuedConnection);
+    }
+    
+    if (m_olderCount > 0) {
+        m_olderCount = 0;
+        emit hasOlderAlertsChanged();
+    }
+    
     emit countChanged();
 }
 
@@ -154,9 +421,17 @@ void AlertLogModel::removeAlert(int index)
         return;
     }
 
+    const Alert removed = m_alerts.at(index);
+    
     beginRemoveRows(QModelIndex(), index, index);
+    releaseSnapshot(removed);
+    forgetAlerts({ removed.seq });
+    m_positionBySeq.remove(removed.seq);
     m_alerts.removeAt(index);
+    reindexFrom(index);
     endRemoveRows();
+    
+    releaseClips({ removed });
     emit countChanged();
     
     qDebug() << "Alert removed at index:" << index;
@@ -168,45 +443,799 @@ void AlertLogModel::removeAlerts(const QVariantList &indices)
         return;
     }
 
-    // Convert to sorted list of integers in descending order
-    QList<int> sortedIndices;
+    // Valid rows, ascending and without duplicates
+    QVector<int> rows;
+    rows.reserve(indices.count());
     for (const QVariant &var : indices) {
         bool ok;
         int idx = var.toInt(&ok);
         if (ok && idx >= 0 && idx < m_alerts.count()) {
-            sortedIndices.append(idx);
+            rows.append(idx);
         }
     }
     
-    std::sort(sortedIndices.begin(), sortedIndices.end(), std::greater<int>());
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
     
-    // Remove from highest to lowest
-    for (int idx : sortedIndices) {
-        if (idx >= 0 && idx < m_alerts.count()) {
-            beginRemoveRows(QModelIndex(), idx, idx);
-            m_alerts.removeAt(idx);
+    if (rows.isEmpty()) {
+        return;
+    }
+    
+    // Collapse the selection into contiguous [first, last] ranges
+    QVector<QPair<int, int>> ranges;
+    for (int row : std::as_const(rows)) {
+        if (!ranges.isEmpty() && ranges.last().second == row - 1) {
+            ranges.last().second = row;
+        } else {
+            ranges.append(qMakePair(row, row));
+        }
+    }
+    
+    QVector<qint64> removedSeqs;
+    QVector<Alert> removed;
+    removedSeqs.reserve(rows.count());
+    qint64 releasedBytes = 0;
+    
+    for (int row : std::as_const(rows)) {
+        const Alert &alert = m_alerts.at(row);
+        removedSeqs.append(alert.seq);
+        if (!alert.clipPath.isEmpty()) {
+            removed.append(alert);
+        }
+        releasedBytes += snapshotMemoryCost(alert);
+        m_positionBySeq.remove(alert.seq);
+    }
+    
+    if (ranges.count() <= MAX_REMOVAL_RANGES) {
+        // A few ranges: one removal signal each, back to front so the rows
+        // of the ranges still to go keep their positions
+        for (auto it = ranges.crbegin(); it != ranges.crend(); ++it) {
+            beginRemoveRows(QModelIndex(), it->first, it->second);
+            m_alerts.remove(it->first, it->second - it->first + 1);
             endRemoveRows();
         }
+    } else {
+        // Scattered selection: compact the kept rows in a single pass and
+        // let the views reload once
+        beginResetModel();
+        
+        int write = rows.first();
+        int next = 0;
+        for (int read = rows.first(); read < m_alerts.count(); ++read) {
+            if (next < rows.count() && rows.at(next) == read) {
+                ++next;
+                continue;
+            }
+            if (write != read) {
+                m_alerts[write] = std::move(m_alerts[read]);
+            }
+            ++write;
+        }
+        m_alerts.resize(write);
+        
+        endResetModel();
     }
     
+    // Rows after the lowest removed one moved up
+    reindexFrom(rows.first());
+    
+    adjustSnapshotBytes(-releasedBytes);
+    forgetAlerts(removedSeqs);
+    releaseClips(removed);
+    
     emit countChanged();
-    qDebug() << "Removed" << sortedIndices.count() << "alerts";
+    qDebug() << "Removed" << rows.count() << "alerts in" << ranges.count() << "ranges";
+}
+
+void AlertLogModel::addAlert(const Alert &newAlert)
+{
+    if (mergeRepeat(newAlert)) {
+        return;
+    }
+    
+    // Monotonic 64-bit IDs, continued from the history, never collide - even
+    // for an event and its auto-snapshot created in the same millisecond
+    Alert alert = newAlert;
+    alert.seq = m_nextSeq++;
+    alert.id = QString::number(alert.seq);
+    alert.lastTimestamp = alert.timestamp;
+    
+    if (isMergeable(alert)) {
+        m_lastSeqByKey.insert(mergeKey(alert), alert.seq);
+    }
+    
+    if (!alert.pendingClipPath.isEmpty()) {
+        m_pendingClipSeqs[alert.pendingClipPath].append(alert.seq);
+    }
+    
+    m_pendingAlerts.append(alert);
+    
+    if (m_pendingAlerts.count() >= MAX_PENDING_ALERTS) {
+        flushPendingAlerts();
+    } else if (!m_ingestTimer->isActive()) {
+        m_ingestTimer->start();
+    }
 }
 
-void AlertLogModel::addAlert(const Alert &alert)
+bool AlertLogModel::mergeRepeat(const Alert &alert)
 {
-    beginInsertRows(QModelIndex(), m_alerts.count(), m_alerts.count());
-    m_alerts.append(alert);
+    if (!isMergeable(alert)) {
+        return false;
+    }
+    
+    auto it = m_lastSeqByKey.constFind(mergeKey(alert));
+    if (it == m_lastSeqByKey.constEnd()) {
+        return false;
+    }
+    
+    // The latest alert with the same key is either still queued or a row
+    const qint64 seq = it.value();
+    Alert *target = nullptr;
+    int row = -1;
+    
+    if (!m_pendingAlerts.isEmpty() && seq >= m_pendingAlerts.first().seq) {
+        target = &m_pendingAlerts[static_cast<int>(seq - m_pendingAlerts.first().seq)];
+    } else {
+        row = rowForSeq(seq);
+        if (row < 0) {
+            return false;   // Removed or evicted since
+        }
+        target = &m_alerts[row];
+    }
+    
+    if (target->lastTimestamp.msecsTo(alert.timestamp) > MERGE_WINDOW_MS) {
+        return false;
+    }
+
+    // Repeats inside a clip share its file; a new clip is new evidence
+    const QString &targetClip = target->clipPath.isEmpty() ? target->pendingClipPath : target->clipPath;
+    if (!alert.pendingClipPath.isEmpty() && alert.pendingClipPath != targetClip) {
+        return false;
+    }
+
+    target->repeatCount++;
+    target->lastTimestamp = alert.timestamp;
+    
+    // Rows already shown are refreshed with the next batch
+    if (row >= 0) {
+        m_repeatedSeqs.insert(seq);
+        if (!m_ingestTimer->isActive()) {
+            m_ingestTimer->start();
+        }
+    }
+    
+    return true;
+}
+
+void AlertLogModel::flushPendingAlerts()
+{
+    m_ingestTimer->stop();
+    
+    // One change notification for all rows that absorbed repeats
+    if (!m_repeatedSeqs.isEmpty()) {
+        QVector<Alert> repeated;
+        int firstRow = std::numeric_limits<int>::max();
+        int lastRow = -1;
+        
+        for (qint64 seq : std::as_const(m_repeatedSeqs)) {
+            const int row = rowForSeq(seq);
+            if (row < 0) {
+                continue;
+            }
+            repeated.append(m_alerts.at(row));
+            firstRow = qMin(firstRow, row);
+            lastRow = qMax(lastRow, row);
+        }
+        m_repeatedSeqs.clear();
+        
+        if (lastRow >= 0) {
+            emit dataChanged(index(firstRow), index(lastRow), { RepeatCountRole, LastTimestampRole });
+            persistRepeats(repeated);
+        }
+    }
+    
+    if (m_pendingAlerts.isEmpty()) {
+        return;
+    }
+    
+    QVector<Alert> batch;
+    batch.swap(m_pendingAlerts);
+    
+    persistAlerts(batch);
+    
+    // The whole batch is a single row range
+    const int firstRow = m_alerts.count();
+    qint64 addedBytes = 0;
+    
+    beginInsertRows(QModelIndex(), firstRow, firstRow + batch.count() - 1);
+    for (int i = 0; i < batch.count(); ++i) {
+        m_positionBySeq.insert(batch.at(i).seq, m_positionBase + firstRow + i);
+        addedBytes += snapshotMemoryCost(batch.at(i));
+    }
+    m_alerts.append(batch);
     endInsertRows();
+    
+    adjustSnapshotBytes(addedBytes);
     emit countChanged();
-    emit alertAdded(alert);
+    for (const Alert &alert : std::as_const(batch)) {
+        emit alertAdded(alert);
+    }
+    
+    qDebug() << "Alerts added:" << batch.count();
+    
+    enforceAlertLimit();
+    enforceSnapshotBudget();
+    pruneMergeKeys();
+}
+
+void AlertLogModel::pruneMergeKeys()
+{
+    if (m_lastSeqByKey.count() <= MAX_MERGE_KEYS) {
+        return;
+    }
     
-    qDebug() << "Alert added:" << alert.type << alert.cameraName << alert.message;
+    // Every track gets its own key; forget the ones that can no longer merge
+    const QDateTime now = QDateTime::currentDateTime();
+    for (auto it = m_lastSeqByKey.begin(); it != m_lastSeqByKey.end(); ) {
+        const int row = rowForSeq(it.value());
+        if (row < 0 || m_alerts.at(row).lastTimestamp.msecsTo(now) > MERGE_WINDOW_MS) {
+            it = m_lastSeqByKey.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
-QString AlertLogModel::generateId() const
+bool AlertLogModel::isMergeable(const Alert &alert)
 {
-    return QDateTime::currentDateTime().toString("yyyyMMddHHmmsszzz");
+    // Each snapshot is a distinct image, so those always get their own row
+    return alert.type != "snapshot" && alert.snapshotImage.isNull() && alert.snapshotPath.isEmpty();
+}
+
+QString AlertLogModel::mergeKey(const Alert &alert)
+{
+    return alert.cameraName + QLatin1Char('\n') + alert.type + QLatin1Char('\n') + QString::number(alert.trackId);
+}
+
+int AlertLogModel::loadOlderAlerts(int count)
+{
+    if (count <= 0 || m_olderCount <= 0 || !m_storeOpen) {
+        return 0;
+    }
+    
+    // Rows directly older than the first one in memory, via the primary key
+    AlertQuery query;
+    query.beforeSeq = m_alerts.isEmpty() ? m_nextSeq : m_alerts.first().seq;
+    query.limit = count;
+    
+    QVector<Alert> older = m_store->query(query);
+    if (older.isEmpty()) {
+        m_olderCount = 0;
+        emit hasOlderAlertsChanged();
+        emit countChanged();
+        return 0;
+    }
+    std::reverse(older.begin(), older.end());  // Oldest first, like the rows
+    
+    // Paged-in rows go above the current ones; the row limit is only enforced
+    // on new alerts, so they stay until fresh alerts push them out again.
+    // Their snapshots stay in the store until requested.
+    const int loaded = older.count();
+    
+    beginInsertRows(QModelIndex(), 0, loaded - 1);
+    older.append(m_alerts);
+    m_alerts.swap(older);
+    
+    // Prepending shifts the base instead of every existing entry
+    m_positionBase -= loaded;
+    for (int i = 0; i < loaded; ++i) {
+        m_positionBySeq.insert(m_alerts.at(i).seq, m_positionBase + i);
+    }
+    endInsertRows();
+    
+    m_olderCount = qMax(0, m_olderCount - loaded);
+    
+    emit countChanged();
+    if (m_olderCount == 0) {
+        emit hasOlderAlertsChanged();
+    }
+    
+    qDebug() << "Loaded" << loaded << "older alerts," << m_olderCount << "still in history";
+    return loaded;
+}
+
+void AlertLogModel::enforceAlertLimit()
+{
+    const int excess = m_alerts.count() - m_maxAlerts;
+    if (excess <= 0) {
+        return;
+    }
+    
+    const bool hadOlder = hasOlderAlerts();
+    
+    // Every row is already in the history, so evicting the oldest ones only
+    // has to drop them from memory - in one range
+    qint64 releasedBytes = 0;
+    QVector<Alert> evicted;
+    for (int i = 0; i < excess; ++i) {
+        releasedBytes += snapshotMemoryCost(m_alerts.at(i));
+        if (!m_alerts.at(i).clipPath.isEmpty()) {
+            evicted.append(m_alerts.at(i));
+        }
+    }
+    
+    beginRemoveRows(QModelIndex(), 0, excess - 1);
+    removeFrontFromIndex(excess);
+    m_alerts.remove(0, excess);
+    endRemoveRows();
+    
+    adjustSnapshotBytes(-releasedBytes);
+    releaseClips(evicted);
+    
+    // Without a history database the evicted rows are simply gone
+    if (m_storeOpen) {
+        m_olderCount += excess;
+    }
+    
+    emit countChanged();
+    if (hadOlder != hasOlderAlerts()) {
+        emit hasOlderAlertsChanged();
+    }
+}
+
+void AlertLogModel::enforceSnapshotBudget()
+{
+    if (m_snapshotBytes <= m_maxSnapshotBytes) {
+        return;
+    }
+    
+    // First pass: compress raw images to JPEG, oldest first, so the newest
+    // snapshots stay instantly displayable
+    for (int i = 0; i < m_alerts.count() && m_snapshotBytes > m_maxSnapshotBytes; ++i) {
+        Alert &alert = m_alerts[i];
+        if (alert.snapshotImage.isNull()) {
+            continue;
+        }
+        
+        const qint64 before = snapshotMemoryCost(alert);
+        if (compressSnapshot(alert)) {
+            adjustSnapshotBytes(snapshotMemoryCost(alert) - before);
+        }
+    }
+    
+    if (m_snapshotBytes <= m_maxSnapshotBytes) {
+        return;
+    }
+    
+    // Second pass: drop compressed snapshots that the history database
+    // already holds, again oldest first; they are reloaded on demand. Rows
+    // whose write has not been acknowledged keep theirs: it may still fail.
+    if (!m_storeOpen) {
+        return;
+    }
+    
+    for (int i = 0; i < m_alerts.count() && m_snapshotBytes > m_maxSnapshotBytes; ++i) {
+        Alert &alert = m_alerts[i];
+        if (alert.snapshotJpeg.isEmpty() || !alert.persisted) {
+            continue;
+        }
+        
+        const qint64 freed = alert.snapshotJpeg.size();
+        alert.snapshotJpeg.clear();
+        alert.hasStoredSnapshot = true;
+        adjustSnapshotBytes(-freed);
+    }
+    
+    // Last resort: thumbnails too, which the history also holds
+    for (int i = 0; i < m_alerts.count() && m_snapshotBytes > m_maxSnapshotBytes; ++i) {
+        Alert &alert = m_alerts[i];
+        if (alert.snapshotThumbnailJpeg.isEmpty() || !alert.hasStoredSnapshot) {
+            continue;
+        }
+        
+        const qint64 freed = alert.snapshotThumbnailJpeg.size();
+        alert.snapshotThumbnailJpeg.clear();
+        adjustSnapshotBytes(-freed);
+    }
+}
+
+void AlertLogModel::releaseSnapshot(const Alert &alert)
+{
+    adjustSnapshotBytes(-snapshotMemoryCost(alert));
+}
+
+void AlertLogModel::releaseClips(const QVector<Alert> &removed)
+{
+    // With a history database the store deletes clips along with their rows,
+    // including rows evicted from memory
+    if (m_storeOpen) {
+        return;
+    }
+    
+    // Repeats and extended clips share a file; it goes with its last alert
+    auto inUse = [this](const QString &filePath) {
+        auto uses = [&filePath](const Alert &alert) { return alert.clipPath == filePath; };
+        return std::any_of(m_alerts.cbegin(), m_alerts.cend(), uses) ||
+               std::any_of(m_pendingAlerts.cbegin(), m_pendingAlerts.cend(), uses);
+    };
+    
+    QStringList unused;
+    for (const Alert &alert : removed) {
+        if (!alert.clipPath.isEmpty() && !unused.contains(alert.clipPath) && !inUse(alert.clipPath)) {
+            unused.append(alert.clipPath);
+        }
+    }
+    
+    if (!unused.isEmpty()) {
+        QMetaObject::invokeMethod(m_store, [unused]() {
+            AlertStore::removeClipFiles(unused);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void AlertLogModel::attachEventClip(const QString &filePath)
+{
+    const QVector<qint64> seqs = m_pendingClipSeqs.take(filePath);
+    
+    QVector<qint64> storedSeqs;
+    bool inMemory = false;
+    int firstRow = std::numeric_limits<int>::max();
+    int lastRow = -1;
+    
+    for (qint64 seq : seqs) {
+        // Still queued: stored together with the clip when its batch is flushed
+        if (!m_pendingAlerts.isEmpty() && seq >= m_pendingAlerts.first().seq) {
+            Alert &alert = m_pendingAlerts[static_cast<int>(seq - m_pendingAlerts.first().seq)];
+            alert.clipPath = filePath;
+            alert.pendingClipPath.clear();
+            inMemory = true;
+            continue;
+        }
+        
+        const int row = rowForSeq(seq);
+        if (row >= 0) {
+            m_alerts[row].clipPath = filePath;
+            m_alerts[row].pendingClipPath.clear();
+            inMemory = true;
+            firstRow = qMin(firstRow, row);
+            lastRow = qMax(lastRow, row);
+        }
+        
+        // Evicted rows are only in the history
+        storedSeqs.append(seq);
+    }
+    
+    if (lastRow >= 0) {
+        emit dataChanged(index(firstRow), index(lastRow), { ClipPathRole });
+    }
+    
+    AlertStore *store = m_store;
+    QMetaObject::invokeMethod(m_store, [store, storedSeqs, filePath, inMemory]() {
+        store->attachClip(storedSeqs, filePath, inMemory);
+    }, Qt::QueuedConnection);
+}
+
+void AlertLogModel::discardEventClip(const QString &filePath)
+{
+    // The alerts simply have no clip; only merging looks at the pending path
+    const QVector<qint64> seqs = m_pendingClipSeqs.take(filePath);
+    for (qint64 seq : seqs) {
+        if (!m_pendingAlerts.isEmpty() && seq >= m_pendingAlerts.first().seq) {
+            m_pendingAlerts[static_cast<int>(seq - m_pendingAlerts.first().seq)].pendingClipPath.clear();
+            continue;
+        }
+        const int row = rowForSeq(seq);
+        if (row >= 0) {
+            m_alerts[row].pendingClipPath.clear();
+        }
+    }
+}
+
+void AlertLogModel::adjustSnapshotBytes(qint64 delta)
+{
+    if (delta == 0) {
+        return;
+    }
+    
+    m_snapshotBytes = qMax<qint64>(0, m_snapshotBytes + delta);
+    emit snapshotBytesChanged();
+}
+
+qint64 AlertLogModel::snapshotMemoryCost(const Alert &alert)
+{
+    return alert.snapshotImage.sizeInBytes() + alert.snapshotJpeg.size() + alert.snapshotThumbnailJpeg.size();
+}
+
+bool AlertLogModel::hasSnapshot(const Alert &alert)
+{
+    return !alert.snapshotImage.isNull() || !alert.snapshotJpeg.isEmpty() || alert.hasStoredSnapshot;
+}
+
+bool AlertLogModel::compressSnapshot(Alert &alert)
+{
+    if (alert.snapshotImage.isNull()) {
+        return false;
+    }
+    
+    // Normally done on the store thread; this is the fallback for a burst
+    // that exceeds the budget before the encoded snapshots come back
+    QByteArray jpeg = AlertStore::encodeJpeg(alert.snapshotImage, SNAPSHOT_JPEG_QUALITY);
+    if (jpeg.isEmpty()) {
+        qWarning() << "Failed to compress snapshot for alert:" << alert.id;
+        return false;
+    }
+    
+    alert.snapshotJpeg = jpeg;
+    if (alert.snapshotThumbnailJpeg.isEmpty()) {
+        alert.snapshotThumbnailJpeg = AlertStore::encodeThumbnail(alert.snapshotImage);
+    }
+    alert.snapshotImage = QImage();
+    return true;
+}
+
+QImage AlertLogModel::loadSnapshot(const Alert &alert) const
+{
+    if (!alert.snapshotImage.isNull()) {
+        return alert.snapshotImage;
+    }
+    
+    if (!alert.snapshotJpeg.isEmpty()) {
+        return QImage::fromData(alert.snapshotJpeg, "JPEG");
+    }
+    
+    if (alert.hasStoredSnapshot && m_storeOpen) {
+        return QImage::fromData(m_store->loadSnapshot(alert.seq), "JPEG");
+    }
+    
+    return QImage();
+}
+
+QImage AlertLogModel::loadThumbnail(const Alert &alert) const
+{
+    if (!alert.snapshotThumbnailJpeg.isEmpty()) {
+        return QImage::fromData(alert.snapshotThumbnailJpeg, "JPEG");
+    }
+    
+    if (alert.hasStoredSnapshot && m_storeOpen) {
+        const QByteArray thumbnail = m_store->loadThumbnail(alert.seq);
+        if (!thumbnail.isEmpty()) {
+            return QImage::fromData(thumbnail, "JPEG");
+        }
+    }
+    
+    // Not encoded yet, or stored before thumbnails existed
+    return QImage::fromData(AlertStore::encodeThumbnail(loadSnapshot(alert)), "JPEG");
+}
+
+QImage AlertLogModel::snapshotImage(const QString &id) const
+{
+    Alert alert;
+    if (findAlert(id, &alert)) {
+        return loadSnapshot(alert);
+    }
+    
+    return QImage();
+}
+
+QImage AlertLogModel::snapshotThumbnail(const QString &id) const
+{
+    Alert alert;
+    if (findAlert(id, &alert)) {
+        return loadThumbnail(alert);
+    }
+    
+    return QImage();
+}
+
+QByteArray AlertLogModel::snapshotJpeg(const Alert &alert, bool thumbnail) const
+{
+    if (thumbnail) {
+        if (!alert.snapshotThumbnailJpeg.isEmpty()) {
+            return alert.snapshotThumbnailJpeg;
+        }
+        if (alert.hasStoredSnapshot && m_storeOpen) {
+            const QByteArray stored = m_store->loadThumbnail(alert.seq);
+            if (!stored.isEmpty()) {
+                return stored;
+            }
+        }
+        
+        const QImage image = loadSnapshot(alert);
+        return image.isNull() ? QByteArray() : AlertStore::encodeThumbnail(image);
+    }
+    
+    if (!alert.snapshotJpeg.isEmpty()) {
+        return alert.snapshotJpeg;
+    }
+    
+    // Raw until the store thread has encoded it
+    if (!alert.snapshotImage.isNull()) {
+        return AlertStore::encodeJpeg(alert.snapshotImage, SNAPSHOT_JPEG_QUALITY);
+    }
+    
+    if (alert.hasStoredSnapshot && m_storeOpen) {
+        return m_store->loadSnapshot(alert.seq);
+    }
+    
+    return QByteArray();
+}
+
+void AlertLogModel::schedulePublish()
+{
+    m_publishedSnapshotBytes.store(m_snapshotBytes, std::memory_order_relaxed);
+    
+    // Coalesced, so a batch of changes copies the rows at most once
+    if (m_publishPending) {
+        return;
+    }
+    m_publishPending = true;
+    QMetaObject::invokeMethod(this, &AlertLogModel::publishSnapshot, Qt::QueuedConnection);
+}
+
+void AlertLogModel::publishSnapshot()
+{
+    m_publishPending = false;
+    
+    // Only takes a reference; the next change to m_alerts detaches it
+    QMutexLocker locker(&m_snapshotMutex);
+    m_snapshot = m_alerts;
+    m_publishedRevision.fetch_add(1, std::memory_order_acq_rel);
+}
+
+quint64 AlertLogModel::queryRevision() const
+{
+    return m_storeOpen ? m_store->revision() : m_publishedRevision.load(std::memory_order_acquire);
+}
+
+void AlertLogModel::applyStoredAlerts(const QVector<EncodedSnapshot> &encoded, const QVector<qint64> &storedSeqs)
+{
+    for (qint64 seq : storedSeqs) {
+        const int row = rowForSeq(seq);
+        if (row >= 0) {
+            m_alerts[row].persisted = true;
+        }
+    }
+    
+    int firstRow = std::numeric_limits<int>::max();
+    int lastRow = -1;
+    
+    for (const EncodedSnapshot &snapshot : encoded) {
+        const int row = rowForSeq(snapshot.seq);
+        if (row < 0) {
+            continue;   // Removed in the meantime
+        }
+        
+        // The raw image may already have been compressed or dropped by the
+        // budget; only replace what is still held
+        Alert &alert = m_alerts[row];
+        const qint64 before = snapshotMemoryCost(alert);
+        
+        if (!alert.snapshotImage.isNull()) {
+            alert.snapshotJpeg = snapshot.jpeg;
+            alert.snapshotImage = QImage();
+        }
+        if (alert.snapshotThumbnailJpeg.isEmpty()) {
+            alert.snapshotThumbnailJpeg = snapshot.thumbnailJpeg;
+        }
+        
+        adjustSnapshotBytes(snapshotMemoryCost(alert) - before);
+        firstRow = qMin(firstRow, row);
+        lastRow = qMax(lastRow, row);
+    }
+    
+    if (lastRow >= 0) {
+        emit dataChanged(index(firstRow), index(lastRow), { HasThumbnailRole });
+    }
+    
+    enforceSnapshotBudget();
+}
+
+void AlertLogModel::rebuildIndex()
+{
+    m_positionBase = 0;
+    m_positionBySeq.clear();
+    m_positionBySeq.reserve(m_alerts.count());
+    
+    for (int i = 0; i < m_alerts.count(); ++i) {
+        m_positionBySeq.insert(m_alerts.at(i).seq, i);
+    }
+}
+
+void AlertLogModel::reindexFrom(int row)
+{
+    for (int i = row; i < m_alerts.count(); ++i) {
+        m_positionBySeq[m_alerts.at(i).seq] = m_positionBase + i;
+    }
+}
+
+void AlertLogModel::removeFrontFromIndex(int count)
+{
+    // Dropping rows from the front keeps every other position valid once
+    // the base moves past them
+    for (int i = 0; i < count; ++i) {
+        m_positionBySeq.remove(m_alerts.at(i).seq);
+    }
+    m_positionBase += count;
+}
+
+void AlertLogModel::persistAlerts(const QVector<Alert> &alerts)
+{
+    const bool hasRawSnapshots = std::any_of(alerts.cbegin(), alerts.cend(),
+        [](const Alert &alert) { return !alert.snapshotImage.isNull(); });
+    
+    // Without a history database the store thread still encodes snapshots
+    if (alerts.isEmpty() || (!m_storeOpen && !hasRawSnapshots)) {
+        return;
+    }
+    
+    // The copies share image data with the rows; JPEG encoding happens on
+    // the store thread, and the results come back to replace the raw images
+    AlertStore *store = m_store;
+    QMetaObject::invokeMethod(m_store, [this, store, alerts]() {
+        QVector<qint64> storedSeqs;
+        const QVector<EncodedSnapshot> encoded = store->appendAlerts(alerts, &storedSeqs);
+        if (!encoded.isEmpty() || !storedSeqs.isEmpty()) {
+            QMetaObject::invokeMethod(this, [this, encoded, storedSeqs]() {
+                applyStoredAlerts(encoded, storedSeqs);
+            }, Qt::QueuedConnection);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void AlertLogModel::persistRepeats(const QVector<Alert> &alerts)
+{
+    if (!m_storeOpen || alerts.isEmpty()) {
+        return;
+    }
+    
+    AlertStore *store = m_store;
+    QMetaObject::invokeMethod(m_store, [store, alerts]() {
+        store->updateRepeats(alerts);
+    }, Qt::QueuedConnection);
+}
+
+void AlertLogModel::forgetAlerts(const QVector<qint64> &seqs)
+{
+    if (!m_storeOpen || seqs.isEmpty()) {
+        return;
+    }
+    
+    AlertStore *store = m_store;
+    QMetaObject::invokeMethod(m_store, [store, seqs]() {
+        store->removeAlerts(seqs);
+    }, Qt::QueuedConnection);
+}
+
+void AlertLogModel::onExpiredPurged(const QDateTime &cutoff, int removedCount)
+{
+    // The purged rows are the oldest ones: first those not in memory...
+    const int olderPurged = qMin(m_olderCount, removedCount);
+    m_olderCount -= olderPurged;
+    
+    // ...then any expired rows still at the top of the model
+    int expiredRows = 0;
+    while (expiredRows < m_alerts.count() && m_alerts.at(expiredRows).timestamp < cutoff) {
+        ++expiredRows;
+    }
+    
+    if (expiredRows > 0) {
+        qint64 releasedBytes = 0;
+        for (int i = 0; i < expiredRows; ++i) {
+            releasedBytes += snapshotMemoryCost(m_alerts.at(i));
+        }
+        
+        beginRemoveRows(QModelIndex(), 0, expiredRows - 1);
+        removeFrontFromIndex(expiredRows);
+        m_alerts.remove(0, expiredRows);
+        endRemoveRows();
+        
+        adjustSnapshotBytes(-releasedBytes);
+    }
+    
+    emit countChanged();
+    if (olderPurged > 0 && m_olderCount == 0) {
+        emit hasOlderAlertsChanged();
+    }
 }
 
 QString AlertLogModel::getSuggestedPngFilename(int index) const
@@ -234,8 +1263,9 @@ bool AlertLogModel::exportSnapshotAsPng(int index, const QString &filePath)
     }
     
     const Alert &alert = m_alerts.at(index);
+    QImage image = loadSnapshot(alert);
     
-    if (alert.snapshotImage.isNull()) {
+    if (image.isNull()) {
         qWarning() << "No image available for alert at index:" << index;
         return false;
     }
@@ -251,7 +1281,7 @@ bool AlertLogModel::exportSnapshotAsPng(int index, const QString &filePath)
     }
     
     // Save the image as PNG
-    if (!alert.snapshotImage.save(filePath, "PNG")) {
+    if (!image.save(filePath, "PNG")) {
         qWarning() << "Failed to save PNG to:" << filePath;
         return false;
     }
@@ -263,151 +1293,143 @@ bool AlertLogModel::exportSnapshotAsPng(int index, const QString &filePath)
     mutableAlert.snapshotPath = filePath;
     mutableAlert.message = "Snapshot saved";
     
-    // Notify that this row changed
+    // Notify that this row changed; this also republishes the rows the HTTP
+    // server reads
     QModelIndex modelIndex = createIndex(index, 0);
     emit dataChanged(modelIndex, modelIndex);
     
+    // Keep the history in step, so the change survives a restart and shows
+    // up in history queries
+    if (m_storeOpen) {
+        AlertStore *store = m_store;
+        const qint64 seq = mutableAlert.seq;
+        const QString message = mutableAlert.message;
+        QMetaObject::invokeMethod(m_store, [store, seq, filePath, message]() {
+            store->updateSnapshotPath(seq, filePath, message);
+        }, Qt::QueuedConnection);
+    }
+    
     return true;
 }
 
 bool AlertLogModel::exportToCsv(const QString &filePath)
 {
-    return exportAlertsToCsv(filePath, m_alerts);
+    return m_storeOpen ? startExport(filePath, "csv", {}, true)
+                       : startExport(filePath, "csv", exportRows({}));
 }
 
 bool AlertLogModel::exportToJson(const QString &filePath)
 {
-    return exportAlertsToJson(filePath, m_alerts);
+    return m_storeOpen ? startExport(filePath, "json", {}, true)
+                       : startExport(filePath, "json", exportRows({}));
 }
 
 bool AlertLogModel::exportSelectedToCsv(const QString &filePath, const QVariantList &indices)
 {
-    QVector<Alert> selectedAlerts;
-    
-    for (const QVariant &var : indices) {
-        bool ok;
-        int idx = var.toInt(&ok);
-        if (ok && idx >= 0 && idx < m_alerts.count()) {
-            selectedAlerts.append(m_alerts.at(idx));
-        }
-    }
-    
-    if (selectedAlerts.isEmpty()) {
-        qWarning() << "No valid alerts to export";
-        return false;
-    }
-    
-    return exportAlertsToCsv(filePath, selectedAlerts);
+    return startExport(filePath, "csv", exportRows(indices));
 }
 
 bool AlertLogModel::exportSelectedToJson(const QString &filePath, const QVariantList &indices)
 {
-    QVector<Alert> selectedAlerts;
+    return startExport(filePath, "json", exportRows(indices));
+}
+
+void AlertLogModel::cancelExport()
+{
+    if (m_exporter) {
+        m_exporter->cancel();
+    }
+}
+
+QVector<Alert> AlertLogModel::exportRows(const QVariantList &indices) const
+{
+    QVector<Alert> rows;
     
+    // No indices: the whole log
+    if (indices.isEmpty()) {
+        rows.reserve(m_alerts.count());
+        for (const Alert &alert : m_alerts) {
+            rows.append(exportCopy(alert));
+        }
+        return rows;
+    }
+    
+    rows.reserve(indices.count());
     for (const QVariant &var : indices) {
         bool ok;
         int idx = var.toInt(&ok);
         if (ok && idx >= 0 && idx < m_alerts.count()) {
-            selectedAlerts.append(m_alerts.at(idx));
+            rows.append(exportCopy(m_alerts.at(idx)));
         }
     }
     
-    if (selectedAlerts.isEmpty()) {
-        qWarning() << "No valid alerts to export";
-        return false;
-    }
-    
-    return exportAlertsToJson(filePath, selectedAlerts);
+    return rows;
 }
 
-bool AlertLogModel::exportAlertsToCsv(const QString &filePath, const QVector<Alert> &alerts)
+Alert AlertLogModel::exportCopy(const Alert &alert)
 {
-    QFileInfo fileInfo(filePath);
-    QDir dir = fileInfo.dir();
-    if (!dir.exists()) {
-        if (!dir.mkpath(".")) {
-            qWarning() << "Failed to create directory:" << dir.path();
-            return false;
-        }
-    }
+    // The export only needs to know whether there is a snapshot; leaving the
+    // image data behind keeps the copy small and lets eviction free it
+    Alert copy = alert;
+    copy.hasStoredSnapshot = hasSnapshot(alert);
+    copy.snapshotImage = QImage();
+    copy.snapshotJpeg.clear();
+    copy.snapshotThumbnailJpeg.clear();
+    return copy;
+}
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "Failed to open file for writing:" << filePath;
+bool AlertLogModel::startExport(const QString &filePath, const QString &format, const QVector<Alert> &alerts,
+                                bool wholeHistory)
+{
+    if (m_exporter) {
+        qWarning() << "An alert export is already running";
         return false;
     }
-
-    QTextStream out(&file);
     
-    // Write CSV header
-    out << "ID,Timestamp,Camera Name,Type,Message,Snapshot Path\n";
-
-    // Write data rows
-    for (const Alert &alert : alerts) {
-        auto escape = [](const QString &field) -> QString {
-            QString escaped = field;
-            escaped.replace("\"", "\"\"");
-            if (escaped.contains(",") || escaped.contains("\"") || escaped.contains("\n")) {
-                escaped = "\"" + escaped + "\"";
-            }
-            return escaped;
-        };
-
-        out << escape(alert.id) << ","
-            << escape(alert.timestamp.toString(Qt::ISODate)) << ","
-            << escape(alert.cameraName) << ","
-            << escape(alert.type) << ","
-            << escape(alert.message) << ","
-            << escape(alert.snapshotPath) << "\n";
+    if (wholeHistory ? totalCount() == 0 && m_pendingAlerts.isEmpty() : alerts.isEmpty()) {
+        qWarning() << "No valid alerts to export";
+        return false;
     }
-
-    file.close();
-    qDebug() << "Exported" << alerts.count() << "alerts to CSV:" << filePath;
-    return true;
-}
-
-bool AlertLogModel::exportAlertsToJson(const QString &filePath, const QVector<Alert> &alerts)
-{
-    QFileInfo fileInfo(filePath);
-    QDir dir = fileInfo.dir();
-    if (!dir.exists()) {
-        if (!dir.mkpath(".")) {
-            qWarning() << "Failed to create directory:" << dir.path();
-            return false;
-        }
+    
+    const AlertExporter::Format exportFormat =
+        format == "csv" ? AlertExporter::Format::Csv : AlertExporter::Format::Json;
+    
+    m_exportThread = new QThread(this);
+    m_exportThread->setObjectName("AlertExport");
+    if (wholeHistory) {
+        // The exporter waits for these writes before it pages through the history
+        flushPendingAlerts();
+        m_exporter = new AlertExporter(filePath, exportFormat, m_store);
+    } else {
+        m_exporter = new AlertExporter(filePath, exportFormat, alerts);
     }
-
-    QJsonArray alertsArray;
-
-    for (const Alert &alert : alerts) {
-        QJsonObject alertObj;
-        alertObj["id"] = alert.id;
-        alertObj["timestamp"] = alert.timestamp.toString(Qt::ISODate);
-        alertObj["cameraName"] = alert.cameraName;
-        alertObj["type"] = alert.type;
-        alertObj["message"] = alert.message;
-        alertObj["snapshotPath"] = alert.snapshotPath;
-        alertObj["hasImage"] = !alert.snapshotImage.isNull();
+    m_exporter->moveToThread(m_exportThread);
+    
+    connect(m_exportThread, &QThread::started, m_exporter, &AlertExporter::run);
+    connect(m_exportThread, &QThread::finished, m_exporter, &QObject::deleteLater);
+    connect(m_exportThread, &QThread::finished, m_exportThread, &QObject::deleteLater);
+    
+    connect(m_exporter, &AlertExporter::progressChanged, this, [this](int written, int total) {
+        m_exportProgress = total > 0 ? static_cast<double>(written) / total : 1.0;
+        emit exportProgressChanged();
+    });
+    
+    connect(m_exporter, &AlertExporter::finished, this,
+            [this, filePath, format](bool success, const QString &error) {
+        m_exportThread->quit();
+        m_exportThread = nullptr;
+        m_exporter = nullptr;
         
-        alertsArray.append(alertObj);
-    }
-
-    QJsonObject root;
-    root["alerts"] = alertsArray;
-    root["exportTime"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-    root["totalCount"] = alerts.count();
-
-    QJsonDocument doc(root);
-
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "Failed to open file for writing:" << filePath;
-        return false;
-    }
-
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
+        emit exportingChanged();
+        emit exportFinished(filePath, format, success, error);
+    });
     
-    qDebug() << "Exported" << alerts.count() << "alerts to JSON:" << filePath;
+    m_exportProgress = 0.0;
+    emit exportProgressChanged();
+    
+    m_exportThread->start();
+    emit exportingChanged();
+    
+    qDebug() << "Exporting" << (wholeHistory ? totalCount() : alerts.count()) << "alerts to" << filePath;
     return true;
-}
\ No newline at end of file
+}
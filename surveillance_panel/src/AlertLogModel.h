@@ -6,27 +6,75 @@
 #include <QString>
 #include <QVector>
 #include <QImage>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <atomic>
 
 /**
  * @brief Structure representing a single alert entry
  */
 struct Alert {
-    QString id;
+    qint64 seq = 0;         // Monotonic alert number, key in the persistent history
+    QString id;             // seq as a string, as exposed to QML and HTTP
     QDateTime timestamp;
     QString cameraName;
     QString type;           // "snapshot", "motion", etc.
     QString message;
     QString snapshotPath;   // Optional, for snapshot alerts
     QImage snapshotImage;   // NEW: In-memory image for unsaved snapshots
+    QByteArray snapshotJpeg;  // Compressed snapshot, replaces the raw image once encoded
+    QByteArray snapshotThumbnailJpeg;  // Small preview for the alert list
+    bool hasStoredSnapshot = false;  // Snapshot only in the history database, loaded on demand
+    bool persisted = false;  // Row, snapshot included, committed to the history database
+    int trackId = -1;       // Tracked object that raised the alert, -1 if none
+    int repeatCount = 1;    // Occurrences merged into this row
+    QDateTime lastTimestamp;  // Time of the latest merged occurrence
+    QString clipPath;       // Video clip around the event, set once the file has been written
+    QString pendingClipPath;  // Clip still being written; not persisted or exposed
 };
 
+class AlertStore;
+struct AlertQuery;
+struct EncodedSnapshot;
+class QThread;
+class QTimer;
+class AlertExporter;
+
 /**
  * @brief Model for managing and displaying alert log entries
+ *
+ * Every alert is also written to a persistent AlertStore on a background
+ * thread, so the model only keeps a window of the history in memory. The
+ * store thread also compresses each snapshot to JPEG with a thumbnail, after
+ * which the raw image is dropped; the full image is only decoded on demand,
+ * the list shows the thumbnails through AlertSnapshotProvider. Once
+ * the snapshot images exceed maxSnapshotBytes, the oldest are compressed to
+ * JPEG and, if that is not enough, dropped and reloaded from the store on
+ * demand. Once the row count exceeds maxAlerts, the oldest rows are evicted,
+ * and QML can page them back in from the store with loadOlderAlerts().
+ *
+ * New alerts are queued and inserted in batches, one row range per
+ * ingestion interval, and repeats of the same type, camera and track within
+ * a few seconds are merged into one row with a count and a time span, so an
+ * alert storm does not re-lay out the views on every event.
+ *
+ * Exports run on a worker thread; the export functions only start them and
+ * report the outcome through exportFinished(). Exporting everything covers
+ * the whole history, not just the rows in memory.
  */
 class AlertLogModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(int totalCount READ totalCount NOTIFY countChanged)
+    Q_PROPERTY(bool hasOlderAlerts READ hasOlderAlerts NOTIFY hasOlderAlertsChanged)
+    Q_PROPERTY(int maxAlerts READ maxAlerts WRITE setMaxAlerts NOTIFY maxAlertsChanged)
+    Q_PROPERTY(qint64 maxSnapshotBytes READ maxSnapshotBytes WRITE setMaxSnapshotBytes NOTIFY maxSnapshotBytesChanged)
+    Q_PROPERTY(qint64 snapshotBytes READ snapshotBytes NOTIFY snapshotBytesChanged)
+    Q_PROPERTY(bool exporting READ isExporting NOTIFY exportingChanged)
+    Q_PROPERTY(double exportProgress READ exportProgress NOTIFY exportProgressChanged)
 
 public:
     enum AlertRoles {
@@ -36,10 +84,77 @@ public:
         TypeRole,
         MessageRole,
         SnapshotPathRole,
-        HasImageRole        // NEW: Indicates if alert has an in-memory image
+        HasImageRole,       // NEW: Indicates if alert has an in-memory image
+        RepeatCountRole,
+        LastTimestampRole,
+        HasThumbnailRole,
+        ClipPathRole
     };
 
     explicit AlertLogModel(QObject *parent = nullptr);
+    ~AlertLogModel();
+
+    // Opens the alert history database in dirPath and loads the newest alerts
+    void setStorageDirectory(const QString &dirPath);
+    
+    // O(1) lookup of an alert's row by ID or sequence number; -1 if it is not in memory
+    int rowForId(const QString &id) const;
+    int rowForSeq(qint64 seq) const;
+    
+    // Row access for proxy models; row must be valid
+    const Alert &alertAt(int row) const { return m_alerts.at(row); }
+    
+    // The functions below are safe to call from any thread. They read a copy
+    // of the rows that shares its data with the model and is republished
+    // after every change, so they may lag the model by one event loop turn.
+    
+    // Copy of the rows in memory, oldest first
+    QVector<Alert> alertsSnapshot() const;
+    
+    // Changes whenever the rows queryAlerts() reads from do: the history's
+    // revision, or the copy above when there is no history. It only moves
+    // once the change is visible to queryAlerts(), never ahead of it.
+    quint64 queryRevision() const;
+    
+    // snapshotBytes() as of the last change
+    qint64 publishedSnapshotBytes() const { return m_publishedSnapshotBytes.load(std::memory_order_relaxed); }
+    
+    // Finds an alert by ID in memory or, failing that, in the history
+    bool findAlert(const QString &id, Alert *alert) const;
+    
+    // Snapshot of an alert in memory or in the history, decoded on demand
+    QImage snapshotImage(const QString &id) const;
+    QImage snapshotThumbnail(const QString &id) const;
+    
+    // The alert's snapshot as JPEG, without decoding: the bytes already kept
+    // in memory or in the history where possible, encoded here otherwise.
+    // Empty if the alert has no snapshot.
+    QByteArray snapshotJpeg(const Alert &alert, bool thumbnail) const;
+    
+    // Query over the whole history, newest first unless asked otherwise, or
+    // over the rows in memory when no history database is open
+    QVector<Alert> queryAlerts(const AlertQuery &query) const;
+    
+    // Outcome of a clip passed to an add*Alert() function: a saved clip is
+    // attached to every alert that asked for it, a failed one is forgotten.
+    // A clip whose alerts are all gone by then is deleted.
+    void attachEventClip(const QString &filePath);
+    void discardEventClip(const QString &filePath);
+
+    // Memory budget
+    int maxAlerts() const { return m_maxAlerts; }
+    void setMaxAlerts(int maxAlerts);
+    qint64 maxSnapshotBytes() const { return m_maxSnapshotBytes; }
+    void setMaxSnapshotBytes(qint64 bytes);
+    qint64 snapshotBytes() const { return m_snapshotBytes; }
+
+    // Rows in memory plus older rows that are only in the history database
+    int totalCount() const { return m_alerts.count() + m_olderCount; }
+    bool hasOlderAlerts() const { return m_olderCount > 0; }
+
+    // Pages up to count older alerts back in from the history above the
+    // current rows. Returns the number of rows loaded.
+    Q_INVOKABLE int loadOlderAlerts(int count = 100);
 
     // QAbstractListModel interface
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -50,24 +165,33 @@ public:
     Q_INVOKABLE void addSnapshotAlert(const QString &cameraName, const QImage &image);
     Q_INVOKABLE void addMotionAlert(const QString &cameraName, 
                                      const QString &message = QString("Motion detected"),
-                                     const QString &snapshotPath = QString());
+                                     const QString &snapshotPath = QString(),
+                                     const QString &clipPath = QString());
     Q_INVOKABLE void addRoiMotionAlert(const QString &cameraName,
                                         const QString &message,
-                                        const QString &snapshotPath = QString());
+                                        const QString &snapshotPath = QString(),
+                                        const QString &clipPath = QString());
     Q_INVOKABLE void addTripwireAlert(const QString &cameraName,
                                        const QString &message,
                                        const QString &snapshotPath = QString(),
-                                       int direction = 0);
+                                       int direction = 0,
+                                       int trackId = -1,
+                                       const QString &clipPath = QString());
     Q_INVOKABLE void addLoiteringAlert(const QString &cameraName,
                                         const QString &message,
-                                        const QString &snapshotPath = QString());
+                                        const QString &snapshotPath = QString(),
+                                        int trackId = -1,
+                                        const QString &clipPath = QString());
     Q_INVOKABLE void clear();
     
-    // Export functions
+    // Export functions - return whether the export started; one runs at a time
     Q_INVOKABLE bool exportToCsv(const QString &filePath);
     Q_INVOKABLE bool exportToJson(const QString &filePath);
     Q_INVOKABLE bool exportSelectedToCsv(const QString &filePath, const QVariantList &indices);
     Q_INVOKABLE bool exportSelectedToJson(const QString &filePath, const QVariantList &indices);
+    Q_INVOKABLE void cancelExport();
+    bool isExporting() const { return m_exporter != nullptr; }
+    double exportProgress() const { return m_exportProgress; }
     Q_INVOKABLE bool exportSnapshotAsPng(int index, const QString &filePath);  // NEW
     
     // Removal functions
@@ -80,14 +204,103 @@ public:
 signals:
     void countChanged();
     void alertAdded(const Alert &alert);
+    void hasOlderAlertsChanged();
+    void maxAlertsChanged();
+    void maxSnapshotBytesChanged();
+    void snapshotBytesChanged();
+    void exportingChanged();
+    void exportProgressChanged();
+    void exportFinished(const QString &filePath, const QString &format, bool success, const QString &error);
 
 private:
     void addAlert(const Alert &alert);
-    QString generateId() const;
-    bool exportAlertsToCsv(const QString &filePath, const QVector<Alert> &alerts);
-    bool exportAlertsToJson(const QString &filePath, const QVector<Alert> &alerts);
+
+    // Ingestion queue: alerts are inserted in one row range per interval
+    void flushPendingAlerts();
+    bool mergeRepeat(const Alert &alert);
+    void pruneMergeKeys();
+    static bool isMergeable(const Alert &alert);
+    static QString mergeKey(const Alert &alert);
+
+    // ID index: seq -> logical position, where row = position - m_positionBase.
+    // Appending and evicting from the front are O(1) per row; only removals in
+    // the middle renumber the rows after them.
+    void rebuildIndex();
+    void reindexFrom(int row);
+    void removeFrontFromIndex(int count);
+
+    // Memory budget enforcement
+    void enforceAlertLimit();
+    void enforceSnapshotBudget();
+    void releaseSnapshot(const Alert &alert);
+    void releaseClips(const QVector<Alert> &removed);
+    void adjustSnapshotBytes(qint64 delta);
+    static qint64 snapshotMemoryCost(const Alert &alert);
+    static bool hasSnapshot(const Alert &alert);
+    static bool compressSnapshot(Alert &alert);
+    QImage loadSnapshot(const Alert &alert) const;
+    QImage loadThumbnail(const Alert &alert) const;
+    // Store acknowledgement of a batch: encoded snapshots replace the raw
+    // images, and committed rows become eligible for dropping their JPEG
+    void applyStoredAlerts(const QVector<EncodedSnapshot> &encoded, const QVector<qint64> &storedSeqs);
+
+    // Copy of the rows for other threads, published once per batch of changes
+    void schedulePublish();
+    void publishSnapshot();
+
+    // Persistent history
+    void persistAlerts(const QVector<Alert> &alerts);
+    void forgetAlerts(const QVector<qint64> &seqs);
+    void persistRepeats(const QVector<Alert> &alerts);
+    void onExpiredPurged(const QDateTime &cutoff, int removedCount);
+
+    // Export
+    // wholeHistory exports every alert in the history database instead of alerts
+    bool startExport(const QString &filePath, const QString &format, const QVector<Alert> &alerts,
+                     bool wholeHistory = false);
+    QVector<Alert> exportRows(const QVariantList &indices) const;
+    static Alert exportCopy(const Alert &alert);
 
     QVector<Alert> m_alerts;
+
+    int m_maxAlerts;
+    qint64 m_maxSnapshotBytes;
+    qint64 m_snapshotBytes;
+
+    QThread *m_storeThread;
+    AlertStore *m_store;
+    bool m_storeOpen;
+    qint64 m_nextSeq;
+    int m_olderCount;   // Rows in the history that are older than the first row in memory
+    
+    QHash<qint64, qint64> m_positionBySeq;
+    qint64 m_positionBase;
+    
+    QTimer *m_ingestTimer;
+    QVector<Alert> m_pendingAlerts;       // Not yet in the model, consecutive seqs
+    QSet<qint64> m_repeatedSeqs;          // Rows whose repeat count changed since the last flush
+    QHash<QString, qint64> m_lastSeqByKey;  // Latest alert per type, camera and track
+    QHash<QString, QVector<qint64>> m_pendingClipSeqs;  // Clip not yet written -> alerts waiting for it
+    
+    QThread *m_exportThread;
+    AlertExporter *m_exporter;
+    double m_exportProgress;
+    
+    mutable QMutex m_snapshotMutex;
+    QVector<Alert> m_snapshot;            // Shares its data with m_alerts until either changes
+    bool m_publishPending;
+    std::atomic<quint64> m_publishedRevision;   // Bumped with every published copy
+    std::atomic<qint64> m_publishedSnapshotBytes;
+
+    static constexpr int DEFAULT_MAX_ALERTS = 10000;
+    static constexpr qint64 DEFAULT_MAX_SNAPSHOT_BYTES = 128LL * 1024 * 1024;
+    static constexpr int SNAPSHOT_JPEG_QUALITY = 85;
+    static constexpr int INITIAL_LOAD_COUNT = 500;   // History rows loaded at startup
+    static constexpr int INGEST_INTERVAL_MS = 100;   // Longest an alert waits before it is shown
+    static constexpr int MAX_PENDING_ALERTS = 256;   // Flushes early beyond this
+    static constexpr int MERGE_WINDOW_MS = 5000;     // Repeats closer than this share a row
+    static constexpr int MAX_MERGE_KEYS = 1024;
+    static constexpr int MAX_REMOVAL_RANGES = 16;    // More ranges reset the model instead
 };
 
 #endif // ALERTLOGMODEL_H
\ No newline at end of file
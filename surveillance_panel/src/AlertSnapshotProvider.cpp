@@ -0,0 +1,44 @@
+#include "AlertSnapshotProvider.h"
+#include "AlertLogModel.h"
+
+AlertSnapshotProvider::AlertSnapshotProvider()
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_alertLog(nullptr)
+{
+}
+
+QImage AlertSnapshotProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    const QString kind = id.section('/', 0, 0);
+    const QString alertId = id.section('/', 1, 1);
+    const bool thumbnail = (kind == "thumb");
+
+    QImage image;
+
+    // Safe from the loader thread, without waiting on the GUI thread
+    AlertLogModel *model = m_alertLog.data();
+    if (model) {
+        image = thumbnail ? model->snapshotThumbnail(alertId) : model->snapshotImage(alertId);
+    }
+
+    if (image.isNull()) {
+        QImage placeholder(thumbnail ? 160 : 320, thumbnail ? 120 : 240, QImage::Format_RGB888);
+        placeholder.fill(Qt::darkGray);
+        image = placeholder;
+    }
+
+    if (!thumbnail && requestedSize.isValid()) {
+        image = image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    if (size) {
+        *size = image.size();
+    }
+
+    return image;
+}
+
+void AlertSnapshotProvider::setAlertLogModel(AlertLogModel *model)
+{
+    m_alertLog = model;
+}
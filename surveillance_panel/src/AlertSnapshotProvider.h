@@ -0,0 +1,31 @@
+#ifndef ALERTSNAPSHOTPROVIDER_H
+#define ALERTSNAPSHOTPROVIDER_H
+
+#include <QQuickImageProvider>
+#include <QImage>
+#include <QPointer>
+
+class AlertLogModel;
+
+/**
+ * @brief Image provider for alert snapshots in QML
+ *
+ * Image IDs have the form "thumb/<alertId>" for the list thumbnail and
+ * "full/<alertId>" for the full image, which is only decoded when requested.
+ * Asynchronous Image elements call in from a loader thread, which reads the
+ * model's thread-safe copy of the rows and decodes there.
+ */
+class AlertSnapshotProvider : public QQuickImageProvider
+{
+public:
+    AlertSnapshotProvider();
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+    void setAlertLogModel(AlertLogModel *model);
+
+private:
+    QPointer<AlertLogModel> m_alertLog;
+};
+
+#endif // ALERTSNAPSHOTPROVIDER_H
@@ -0,0 +1,647 @@
+#include "AlertStore.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTimer>
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include <QHash>
+#include <atomic>
+
+namespace {
+// Read connections are named from this, never from the native thread ID,
+// which the OS hands out again once a thread has ended
+std::atomic<quint64> readConnectionCounter{0};
+
+/**
+ * @brief The read connections opened by one thread, removed when it ends
+ *
+ * Pool threads come and go; without this every expired thread would leave
+ * an open SQLite handle behind.
+ */
+struct ThreadReadConnections {
+    QHash<QString, QString> names;  // Store connection -> this thread's read connection
+
+    ~ThreadReadConnections()
+    {
+        for (const QString &name : std::as_const(names)) {
+            {
+                QSqlDatabase db = QSqlDatabase::database(name, false);
+                db.close();
+            }
+            QSqlDatabase::removeDatabase(name);
+        }
+    }
+};
+
+thread_local ThreadReadConnections threadReadConnections;
+
+// Column list shared by every query that returns whole alerts
+const char *const ALERT_COLUMNS =
+    "seq, id, ts, camera, type, message, snapshot_path, snapshot IS NOT NULL, "
+    "track_id, repeat_count, last_ts, clip_path";
+
+Alert alertFromRow(const QSqlQuery &query)
+{
+    Alert alert;
+    alert.seq = query.value(0).toLongLong();
+    alert.id = query.value(1).toString();
+    alert.timestamp = QDateTime::fromMSecsSinceEpoch(query.value(2).toLongLong());
+    alert.cameraName = query.value(3).toString();
+    alert.type = query.value(4).toString();
+    alert.message = query.value(5).toString();
+    alert.snapshotPath = query.value(6).toString();
+    alert.hasStoredSnapshot = query.value(7).toBool();
+    alert.trackId = query.value(8).toInt();
+    alert.repeatCount = qMax(1, query.value(9).toInt());
+    alert.lastTimestamp = query.value(10).isNull() ? alert.timestamp
+        : QDateTime::fromMSecsSinceEpoch(query.value(10).toLongLong());
+    alert.clipPath = query.value(11).toString();
+    alert.persisted = true;
+    return alert;
+}
+}
+
+AlertStore::AlertStore(QObject *parent)
+    : QObject(parent)
+    , m_connectionName(QString("alert_store_%1").arg(reinterpret_cast<quintptr>(this)))
+    , m_retentionTimer(nullptr)
+    , m_retentionDays(DEFAULT_RETENTION_DAYS)
+    , m_revision(0)
+{
+}
+
+AlertStore::~AlertStore()
+{
+    close();
+}
+
+bool AlertStore::open(const QString &databasePath)
+{
+    close();
+
+    QDir().mkpath(QFileInfo(databasePath).absolutePath());
+    m_databasePath = databasePath;
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        db.setDatabaseName(databasePath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+        if (!db.open()) {
+            qWarning() << "Cannot open alert database:" << databasePath << db.lastError().text();
+            return false;
+        }
+    }
+
+    if (!createSchema()) {
+        close();
+        return false;
+    }
+
+    // Drop anything that expired while the application was not running. Not
+    // announced: nothing has been read from the history yet, and the model
+    // counts the rows only after this.
+    removeExpired(QDateTime::currentDateTime().addDays(-m_retentionDays));
+
+    if (!m_retentionTimer) {
+        m_retentionTimer = new QTimer(this);
+        m_retentionTimer->setInterval(RETENTION_CHECK_INTERVAL_MS);
+        connect(m_retentionTimer, &QTimer::timeout, this, &AlertStore::purgeExpired);
+    }
+    m_retentionTimer->start();
+
+    qDebug() << "Alert history opened:" << databasePath;
+    return true;
+}
+
+void AlertStore::close()
+{
+    if (m_retentionTimer) {
+        m_retentionTimer->stop();
+    }
+
+    if (QSqlDatabase::contains(m_connectionName)) {
+        QSqlDatabase::database(m_connectionName, false).close();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+}
+
+bool AlertStore::createSchema()
+{
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    QSqlQuery query(db);
+
+    const QStringList statements = {
+        // WAL lets reader connections on other threads run alongside the writer
+        "PRAGMA journal_mode=WAL",
+        "PRAGMA synchronous=NORMAL",
+        "CREATE TABLE IF NOT EXISTS alerts ("
+        "  seq INTEGER PRIMARY KEY,"
+        "  id TEXT NOT NULL,"
+        "  ts INTEGER NOT NULL,"
+        "  camera TEXT NOT NULL,"
+        "  type TEXT NOT NULL,"
+        "  message TEXT,"
+        "  snapshot_path TEXT,"
+        "  snapshot BLOB,"
+        "  track_id INTEGER NOT NULL DEFAULT -1,"
+        "  repeat_count INTEGER NOT NULL DEFAULT 1,"
+        "  last_ts INTEGER,"
+        "  thumbnail BLOB,"
+        "  clip_path TEXT"
+        ")",
+        // Every query pages by seq; with seq as the second column a camera or
+        // type filter reads its newest rows straight off the index and stops
+        // at the LIMIT instead of sorting every match. The ts index holds the
+        // rowid too, for time windows and the retention purge.
+        "CREATE INDEX IF NOT EXISTS idx_alerts_ts ON alerts(ts)",
+        "CREATE INDEX IF NOT EXISTS idx_alerts_camera_seq ON alerts(camera, seq)",
+        "CREATE INDEX IF NOT EXISTS idx_alerts_type_seq ON alerts(type, seq)",
+        // Finds the remaining references to a clip before its file is deleted
+        "CREATE INDEX IF NOT EXISTS idx_alerts_clip ON alerts(clip_path) WHERE clip_path != ''"
+    };
+
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            qWarning() << "Alert database schema error:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QVector<EncodedSnapshot> AlertStore::appendAlerts(const QVector<Alert> &alerts, QVector<qint64> *storedSeqs)
+{
+    QVector<EncodedSnapshot> encoded;
+
+    // Raw images are compressed once, here, off the GUI thread
+    for (const Alert &alert : alerts) {
+        if (alert.snapshotImage.isNull()) {
+            continue;
+        }
+
+        EncodedSnapshot snapshot;
+        snapshot.seq = alert.seq;
+        snapshot.jpeg = alert.snapshotJpeg.isEmpty()
+            ? encodeJpeg(alert.snapshotImage, SNAPSHOT_JPEG_QUALITY) : alert.snapshotJpeg;
+        snapshot.thumbnailJpeg = encodeThumbnail(alert.snapshotImage);
+
+        if (!snapshot.jpeg.isEmpty()) {
+            encoded.append(snapshot);
+        } else {
+            qWarning() << "Failed to compress snapshot for alert:" << alert.id;
+        }
+    }
+
+    if (alerts.isEmpty() || !QSqlDatabase::contains(m_connectionName)) {
+        return encoded;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR REPLACE INTO alerts (seq, id, ts, camera, type, message, snapshot_path, snapshot, "
+                  "track_id, repeat_count, last_ts, thumbnail, clip_path) "
+                  "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+    QVector<qint64> inserted;
+    int next = 0;
+    for (const Alert &alert : alerts) {
+        QByteArray jpeg = alert.snapshotJpeg;
+        QByteArray thumbnail = alert.snapshotThumbnailJpeg;
+
+        // encoded is in the same order as alerts
+        if (next < encoded.count() && encoded.at(next).seq == alert.seq) {
+            jpeg = encoded.at(next).jpeg;
+            thumbnail = encoded.at(next).thumbnailJpeg;
+            ++next;
+        }
+
+        query.addBindValue(alert.seq);
+        query.addBindValue(alert.id);
+        query.addBindValue(alert.timestamp.toMSecsSinceEpoch());
+        query.addBindValue(alert.cameraName);
+        query.addBindValue(alert.type);
+        query.addBindValue(alert.message);
+        query.addBindValue(alert.snapshotPath);
+        query.addBindValue(jpeg.isEmpty() ? QVariant(QMetaType(QMetaType::QByteArray)) : QVariant(jpeg));
+        query.addBindValue(alert.trackId);
+        query.addBindValue(alert.repeatCount);
+        query.addBindValue(alert.lastTimestamp.isValid() ? alert.lastTimestamp.toMSecsSinceEpoch()
+                                                         : alert.timestamp.toMSecsSinceEpoch());
+        query.addBindValue(thumbnail.isEmpty() ? QVariant(QMetaType(QMetaType::QByteArray)) : QVariant(thumbnail));
+        query.addBindValue(alert.clipPath);
+
+        if (query.exec()) {
+            inserted.append(alert.seq);
+        } else {
+            qWarning() << "Failed to store alert" << alert.id << ":" << query.lastError().text();
+        }
+    }
+
+    if (!db.commit()) {
+        qWarning() << "Failed to commit alerts:" << db.lastError().text();
+        return encoded;
+    }
+    bumpRevision();
+
+    if (storedSeqs) {
+        *storedSeqs = inserted;
+    }
+    return encoded;
+}
+
+QByteArray AlertStore::encodeJpeg(const QImage &image, int quality)
+{
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+
+    if (!image.save(&buffer, "JPEG", quality)) {
+        return QByteArray();
+    }
+
+    return jpeg;
+}
+
+QByteArray AlertStore::encodeThumbnail(const QImage &image)
+{
+    if (image.isNull()) {
+        return QByteArray();
+    }
+
+    const QImage thumbnail = image.scaled(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT,
+                                          Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return encodeJpeg(thumbnail, THUMBNAIL_JPEG_QUALITY);
+}
+
+void AlertStore::updateRepeats(const QVector<Alert> &alerts)
+{
+    if (alerts.isEmpty() || !QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("UPDATE alerts SET repeat_count = ?, last_ts = ? WHERE seq = ?");
+
+    for (const Alert &alert : alerts) {
+        query.addBindValue(alert.repeatCount);
+        query.addBindValue(alert.lastTimestamp.toMSecsSinceEpoch());
+        query.addBindValue(alert.seq);
+        query.exec();
+    }
+
+    db.commit();
+    bumpRevision();
+}
+
+void AlertStore::updateSnapshotPath(qint64 seq, const QString &snapshotPath, const QString &message)
+{
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare("UPDATE alerts SET snapshot_path = ?, message = ? WHERE seq = ?");
+    query.addBindValue(snapshotPath);
+    query.addBindValue(message);
+    query.addBindValue(seq);
+
+    if (!query.exec()) {
+        qWarning() << "Failed to update alert snapshot path:" << query.lastError().text();
+        return;
+    }
+
+    bumpRevision();
+}
+
+void AlertStore::removeAlerts(const QVector<qint64> &seqs)
+{
+    if (seqs.isEmpty() || !QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    db.transaction();
+
+    QSqlQuery select(db);
+    select.prepare("SELECT clip_path FROM alerts WHERE seq = ? AND clip_path != ''");
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM alerts WHERE seq = ?");
+
+    QStringList clips;
+    for (qint64 seq : seqs) {
+        select.addBindValue(seq);
+        if (select.exec() && select.next() && !clips.contains(select.value(0).toString())) {
+            clips.append(select.value(0).toString());
+        }
+        query.addBindValue(seq);
+        query.exec();
+    }
+
+    db.commit();
+    bumpRevision();
+    removeUnreferencedClips(clips);
+}
+
+void AlertStore::removeAll()
+{
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+
+    const QStringList clips = selectClipPaths(QString(), QVariant());
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    if (!query.exec("DELETE FROM alerts")) {
+        qWarning() << "Failed to clear alert history:" << query.lastError().text();
+        return;
+    }
+    bumpRevision();
+    removeClipFiles(clips);
+}
+
+void AlertStore::purgeExpired()
+{
+    const QDateTime cutoff = QDateTime::currentDateTime().addDays(-m_retentionDays);
+    const int removed = removeExpired(cutoff);
+    if (removed > 0) {
+        emit expiredPurged(cutoff, removed);
+    }
+}
+
+int AlertStore::removeExpired(const QDateTime &cutoff)
+{
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return 0;
+    }
+
+    const QStringList clips = selectClipPaths("ts < ?", cutoff.toMSecsSinceEpoch());
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare("DELETE FROM alerts WHERE ts < ?");
+    query.addBindValue(cutoff.toMSecsSinceEpoch());
+
+    if (!query.exec()) {
+        qWarning() << "Failed to purge expired alerts:" << query.lastError().text();
+        return 0;
+    }
+
+    const int removed = query.numRowsAffected();
+    if (removed > 0) {
+        bumpRevision();
+        removeUnreferencedClips(clips);
+        qDebug() << "Purged" << removed << "alerts older than" << m_retentionDays << "days";
+    }
+    return removed;
+}
+
+void AlertStore::attachClip(const QVector<qint64> &seqs, const QString &filePath, bool referencedElsewhere)
+{
+    int updated = 0;
+
+    if (!seqs.isEmpty() && QSqlDatabase::contains(m_connectionName)) {
+        QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+        db.transaction();
+
+        QSqlQuery query(db);
+        query.prepare("UPDATE alerts SET clip_path = ? WHERE seq = ?");
+
+        for (qint64 seq : seqs) {
+            query.addBindValue(filePath);
+            query.addBindValue(seq);
+            if (query.exec()) {
+                updated += query.numRowsAffected();
+            }
+        }
+
+        db.commit();
+        bumpRevision();
+    }
+
+    // Every alert that asked for the clip was removed while it was written
+    if (updated == 0 && !referencedElsewhere) {
+        removeClipFiles({ filePath });
+    }
+}
+
+QStringList AlertStore::selectClipPaths(const QString &condition, const QVariant &value) const
+{
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.setForwardOnly(true);
+    query.prepare("SELECT DISTINCT clip_path FROM alerts WHERE clip_path != ''" +
+                  (condition.isEmpty() ? QString() : " AND " + condition));
+    if (!condition.isEmpty()) {
+        query.addBindValue(value);
+    }
+
+    QStringList clips;
+    if (query.exec()) {
+        while (query.next()) {
+            clips.append(query.value(0).toString());
+        }
+    }
+    return clips;
+}
+
+void AlertStore::removeUnreferencedClips(const QStringList &filePaths)
+{
+    if (filePaths.isEmpty()) {
+        return;
+    }
+
+    // Repeats and extended clips share a file; it goes with its last row
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare("SELECT 1 FROM alerts WHERE clip_path = ? AND clip_path != '' LIMIT 1");
+
+    QStringList unused;
+    for (const QString &filePath : filePaths) {
+        query.addBindValue(filePath);
+        if (query.exec() && !query.next()) {
+            unused.append(filePath);
+        }
+    }
+
+    removeClipFiles(unused);
+}
+
+void AlertStore::removeClipFiles(const QStringList &filePaths)
+{
+    for (const QString &filePath : filePaths) {
+        if (QFile::exists(filePath) && !QFile::remove(filePath)) {
+            qWarning() << "Failed to delete event clip:" << filePath;
+        }
+    }
+}
+
+QSqlDatabase AlertStore::readConnection() const
+{
+    // QSqlDatabase connections must stay on the thread that created them,
+    // so every reading thread gets its own, closed when the thread ends
+    const QString existing = threadReadConnections.names.value(m_connectionName);
+    if (!existing.isEmpty()) {
+        return QSqlDatabase::database(existing);
+    }
+
+    const QString name = QString("%1_read_%2")
+        .arg(m_connectionName)
+        .arg(readConnectionCounter.fetch_add(1, std::memory_order_relaxed));
+    threadReadConnections.names.insert(m_connectionName, name);
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+    db.setDatabaseName(m_databasePath);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=2000");
+
+    if (!db.open()) {
+        qWarning() << "Cannot open alert database for reading:" << db.lastError().text();
+    }
+
+    return db;
+}
+
+QVector<Alert> AlertStore::query(const AlertQuery &filter) const
+{
+    QVector<Alert> alerts;
+
+    QSqlDatabase db = readConnection();
+    if (!db.isOpen()) {
+        return alerts;
+    }
+
+    // Build the WHERE clause from the set filters; each one is backed by an index
+    QStringList conditions;
+    QVariantList values;
+
+    if (filter.since.isValid()) {
+        conditions << "ts >= ?";
+        values << filter.since.toMSecsSinceEpoch();
+    }
+    if (filter.until.isValid()) {
+        conditions << "ts < ?";
+        values << filter.until.toMSecsSinceEpoch();
+    }
+    if (!filter.cameraName.isEmpty()) {
+        conditions << "camera = ?";
+        values << filter.cameraName;
+    }
+    if (!filter.type.isEmpty()) {
+        conditions << "type = ?";
+        values << filter.type;
+    }
+    if (filter.beforeSeq >= 0) {
+        conditions << "seq < ?";
+        values << filter.beforeSeq;
+    }
+    if (filter.afterSeq >= 0) {
+        conditions << "seq > ?";
+        values << filter.afterSeq;
+    }
+
+    QString sql = QString("SELECT %1 FROM alerts").arg(ALERT_COLUMNS);
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+    sql += filter.oldestFirst ? " ORDER BY seq ASC LIMIT ?" : " ORDER BY seq DESC LIMIT ?";
+    values << qMax(0, filter.limit);
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant &value : values) {
+        query.addBindValue(value);
+    }
+
+    if (!query.exec()) {
+        qWarning() << "Alert history query failed:" << query.lastError().text();
+        return alerts;
+    }
+
+    while (query.next()) {
+        alerts.append(alertFromRow(query));
+    }
+
+    return alerts;
+}
+
+bool AlertStore::findAlert(qint64 seq, Alert *alert) const
+{
+    QSqlDatabase db = readConnection();
+    if (!db.isOpen()) {
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare(QString("SELECT %1 FROM alerts WHERE seq = ?").arg(ALERT_COLUMNS));
+    query.addBindValue(seq);
+
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+
+    if (alert) {
+        *alert = alertFromRow(query);
+    }
+
+    return true;
+}
+
+QByteArray AlertStore::loadSnapshot(qint64 seq) const
+{
+    return loadBlob("snapshot", seq);
+}
+
+QByteArray AlertStore::loadThumbnail(qint64 seq) const
+{
+    return loadBlob("thumbnail", seq);
+}
+
+QByteArray AlertStore::loadBlob(const char *column, qint64 seq) const
+{
+    QSqlDatabase db = readConnection();
+    if (!db.isOpen()) {
+        return QByteArray();
+    }
+
+    QSqlQuery query(db);
+    query.prepare(QString("SELECT %1 FROM alerts WHERE seq = ?").arg(QLatin1String(column)));
+    query.addBindValue(seq);
+
+    if (query.exec() && query.next()) {
+        return query.value(0).toByteArray();
+    }
+
+    return QByteArray();
+}
+
+qint64 AlertStore::count() const
+{
+    QSqlDatabase db = readConnection();
+    QSqlQuery query(db);
+
+    if (db.isOpen() && query.exec("SELECT COUNT(*) FROM alerts") && query.next()) {
+        return query.value(0).toLongLong();
+    }
+
+    return 0;
+}
+
+qint64 AlertStore::maxSeq() const
+{
+    QSqlDatabase db = readConnection();
+    QSqlQuery query(db);
+
+    if (db.isOpen() && query.exec("SELECT MAX(seq) FROM alerts") && query.next()) {
+        return query.value(0).toLongLong();
+    }
+
+    return 0;
+}
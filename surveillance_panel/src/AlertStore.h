@@ -0,0 +1,128 @@
+#ifndef ALERTSTORE_H
+#define ALERTSTORE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+#include <QImage>
+#include <atomic>
+#include "AlertLogModel.h"
+
+class QTimer;
+class QSqlDatabase;
+
+/**
+ * @brief Filter for querying the persistent alert history
+ *
+ * Unset members do not filter. Results are always newest first.
+ */
+struct AlertQuery {
+    QDateTime since;         // Inclusive lower bound on the timestamp
+    QDateTime until;         // Exclusive upper bound on the timestamp
+    QString cameraName;
+    QString type;
+    qint64 beforeSeq = -1;   // Only rows older than this sequence number
+    qint64 afterSeq = -1;    // Only rows newer than this sequence number
+    bool oldestFirst = false;
+    int limit = 100;
+};
+
+/**
+ * @brief Compressed forms of an alert snapshot, produced on the store thread
+ */
+struct EncodedSnapshot {
+    qint64 seq = 0;
+    QByteArray jpeg;            // Full image
+    QByteArray thumbnailJpeg;   // Small preview for the alert list
+};
+
+/**
+ * @brief Append-only SQLite history of alerts
+ *
+ * The writer side runs on the thread the store is moved to; the model posts
+ * inserts and deletes to it, so the GUI never waits on disk I/O. Queries are
+ * thread safe: each calling thread reads through its own read-only
+ * connection, which SQLite's WAL mode allows concurrently with the writer,
+ * and which is removed again when that thread ends.
+ * Raw snapshot images are compressed here as well, together with a
+ * thumbnail, whether or not a database is open.
+ * The timestamp column is indexed, as are camera and type together with
+ * the sequence number every query is ordered by, and rows older than
+ * the retention period are purged hourly. An event clip file is deleted
+ * together with the last row that refers to it.
+ */
+class AlertStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AlertStore(QObject *parent = nullptr);
+    ~AlertStore();
+
+    // Writer side - must run on the store's thread
+    bool open(const QString &databasePath);
+    void close();
+    // Returns the snapshots it had to encode, so the caller can drop the raw
+    // images, and in storedSeqs the rows that were committed
+    QVector<EncodedSnapshot> appendAlerts(const QVector<Alert> &alerts, QVector<qint64> *storedSeqs = nullptr);
+    void updateRepeats(const QVector<Alert> &alerts);
+    void updateSnapshotPath(qint64 seq, const QString &snapshotPath, const QString &message);
+    void removeAlerts(const QVector<qint64> &seqs);
+    void removeAll();
+    void purgeExpired();
+    // Sets the clip of the given rows. The file is deleted right away if
+    // none of them exists any more and it is not referenced elsewhere.
+    void attachClip(const QVector<qint64> &seqs, const QString &filePath, bool referencedElsewhere);
+
+    // Reader side - callable from any thread once open() has returned
+    QVector<Alert> query(const AlertQuery &query) const;
+    bool findAlert(qint64 seq, Alert *alert) const;
+    QByteArray loadSnapshot(qint64 seq) const;
+    QByteArray loadThumbnail(qint64 seq) const;
+    qint64 count() const;
+    qint64 maxSeq() const;
+
+    // Bumped after every committed change, so a reader that sees a new
+    // value also sees the change
+    quint64 revision() const { return m_revision.load(std::memory_order_acquire); }
+
+    int retentionDays() const { return m_retentionDays; }
+
+    // Snapshot encoding, thread safe
+    static QByteArray encodeJpeg(const QImage &image, int quality);
+    static QByteArray encodeThumbnail(const QImage &image);
+
+    // Deletes event clip files; any thread
+    static void removeClipFiles(const QStringList &filePaths);
+
+signals:
+    void expiredPurged(const QDateTime &cutoff, int removedCount);
+
+private:
+    bool createSchema();
+    // Deletes rows older than cutoff, returns how many
+    int removeExpired(const QDateTime &cutoff);
+    void bumpRevision() { m_revision.fetch_add(1, std::memory_order_acq_rel); }
+    QStringList selectClipPaths(const QString &condition, const QVariant &value) const;
+    void removeUnreferencedClips(const QStringList &filePaths);
+    QSqlDatabase readConnection() const;
+    QByteArray loadBlob(const char *column, qint64 seq) const;
+
+    QString m_databasePath;
+    QString m_connectionName;
+    QTimer *m_retentionTimer;
+    int m_retentionDays;
+    std::atomic<quint64> m_revision;
+
+    static constexpr int DEFAULT_RETENTION_DAYS = 90;
+    static constexpr int RETENTION_CHECK_INTERVAL_MS = 60 * 60 * 1000;  // Hourly
+    static constexpr int SNAPSHOT_JPEG_QUALITY = 85;
+    static constexpr int THUMBNAIL_JPEG_QUALITY = 75;
+    static constexpr int THUMBNAIL_WIDTH = 160;
+    static constexpr int THUMBNAIL_HEIGHT = 120;
+};
+
+#endif // ALERTSTORE_H
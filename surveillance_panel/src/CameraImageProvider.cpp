@@ -1,17 +1,21 @@
 #include "CameraImageProvider.h"
+#include "CameraManager.h"
 
 CameraImageProvider::CameraImageProvider()
     : QQuickImageProvider(QQuickImageProvider::Image)
-    , m_cameraStream(nullptr)
+    , m_cameraManager(nullptr)
 {
 }
 
 QImage CameraImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
-    Q_UNUSED(id);
     Q_UNUSED(requestedSize);
 
-    if (!m_cameraStream) {
+    // Resolve "<cameraId>/<frameSequence>" with a single registry lookup
+    QString cameraId = id.section('/', 0, 0);
+    CameraStream *stream = m_cameraManager ? m_cameraManager->cameraById(cameraId) : nullptr;
+
+    if (!stream) {
         QImage placeholder(320, 240, QImage::Format_RGB888);
         placeholder.fill(Qt::black);
         if (size) {
@@ -20,7 +24,7 @@ QImage CameraImageProvider::requestImage(const QString &id, QSize *size, const Q
         return placeholder;
     }
 
-    QImage frame = m_cameraStream->frame();
+    QImage frame = stream->frame();
     
     if (frame.isNull()) {
         QImage placeholder(320, 240, QImage::Format_RGB888);
@@ -38,7 +42,7 @@ QImage CameraImageProvider::requestImage(const QString &id, QSize *size, const Q
     return frame;
 }
 
-void CameraImageProvider::setCameraStream(CameraStream *stream)
+void CameraImageProvider::setCameraManager(CameraManager *manager)
 {
-    m_cameraStream = stream;
-}
\ No newline at end of file
+    m_cameraManager = manager;
+}
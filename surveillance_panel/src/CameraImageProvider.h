@@ -5,8 +5,14 @@
 #include <QImage>
 #include "CameraStream.h"
 
+class CameraManager;
+
 /**
  * @brief Image provider for displaying camera frames in QML
+ *
+ * A single instance serves every camera. Image IDs have the form
+ * "<cameraId>/<frameSequence>"; the sequence only exists to make QML
+ * re-request the image and is ignored here.
  */
 class CameraImageProvider : public QQuickImageProvider
 {
@@ -15,10 +21,10 @@ public:
     
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
     
-    void setCameraStream(CameraStream *stream);
+    void setCameraManager(CameraManager *manager);
 
 private:
-    CameraStream *m_cameraStream;
+    CameraManager *m_cameraManager;
 };
 
-#endif // CAMERAIMAGEPROVIDER_H
\ No newline at end of file
+#endif // CAMERAIMAGEPROVIDER_H
@@ -7,10 +7,11 @@
 #include <QDebug>
 #include <QCoreApplication>
 #include <QDir>
+#include <QSet>
 #include <algorithm>
 
 CameraManager::CameraManager(QObject *parent)
-    : QObject(parent)
+    : QAbstractListModel(parent)
 {
     // Construct path to config file
     QString appDir = QCoreApplication::applicationDirPath();
@@ -18,6 +19,9 @@ CameraManager::CameraManager(QObject *parent)
     
     qDebug() << "Loading camera configuration from:" << m_configPath;
     
+    // Shared worker pool for every camera's analysis stages, sized to the core count
+    m_executor = std::make_unique<PipelineExecutor>();
+    
     // Initialize ObjectDetector
     QString modelPath = QDir(appDir).filePath("../assets/models/yolov8n.onnx");
     QString classNamesPath = QDir(appDir).filePath("../assets/models/coco.names");
@@ -64,6 +68,93 @@ CameraManager::~CameraManager()
     // Clean up camera streams
     qDeleteAll(m_cameras);
     m_cameras.clear();
+    m_cameraById.clear();
+    m_cameraInfos.clear();
+}
+
+int CameraManager::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_configs.count();
+}
+
+QVariant CameraManager::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_configs.count()) {
+        return QVariant();
+    }
+
+    const int row = index.row();
+    const CameraConfig &config = m_configs.at(row);
+
+    switch (role) {
+    case CameraIdRole:
+        return config.id;
+    case CameraIndexRole:
+        return row + 1;  // 1-based, matches the index based invokables
+    case NameRole:
+        return config.name;
+    case TypeRole:
+        return config.type;
+    case SourceRole:
+        return config.source;
+    case AvailableRole:
+        return m_cameras.value(row, nullptr) != nullptr;
+    case StreamRole:
+        return QVariant::fromValue<QObject*>(m_cameras.value(row, nullptr));
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> CameraManager::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[CameraIdRole] = "cameraId";
+    roles[CameraIndexRole] = "cameraIndex";
+    roles[NameRole] = "name";
+    roles[TypeRole] = "type";
+    roles[SourceRole] = "source";
+    roles[AvailableRole] = "available";
+    roles[StreamRole] = "stream";
+    return roles;
+}
+
+CameraStream *CameraManager::cameraById(const QString &cameraId) const
+{
+    return m_cameraById.value(cameraId, nullptr);
+}
+
+QVector<CameraStream*> CameraManager::cameras() const
+{
+    QVector<CameraStream*> result;
+    result.reserve(m_cameraById.size());
+    
+    for (CameraStream *stream : m_cameras) {
+        if (stream) {
+            result.append(stream);
+        }
+    }
+    
+    return result;
+}
+
+QObject *CameraManager::camera(int index) const
+{
+    int idx = index - 1; // Convert 1-based to 0-based
+    
+    return m_cameras.value(idx, nullptr);
+}
+
+QString CameraManager::cameraId(int index) const
+{
+    int idx = index - 1; // Convert 1-based to 0-based
+    
+    if (idx >= 0 && idx < m_configs.size()) {
+        return m_configs[idx].id;
+    }
+    
+    return QString();
 }
 
 bool CameraManager::loadConfiguration(const QString &configPath)
@@ -89,12 +180,13 @@ bool CameraManager::loadConfiguration(const QString &configPath)
     QJsonArray camerasArray = root["cameras"].toArray();
 
     m_configs.clear();
+    QSet<QString> usedIds;
 
     for (const QJsonValue &value : camerasArray) {
         QJsonObject camObj = value.toObject();
         
         CameraConfig config;
-        config.id = camObj["id"].toString();  // Now string
+        config.id = camObj["id"].toVariant().toString();  // Accept numeric IDs too
         config.name = camObj["name"].toString();
         config.type = camObj["type"].toString();
         config.source = camObj["source"].toVariant().toString();
@@ -138,14 +230,20 @@ bool CameraManager::loadConfiguration(const QString &configPath)
             }
         }
 
+        // IDs key the camera registry, image provider and HTTP routes
+        if (config.id.isEmpty() || usedIds.contains(config.id)) {
+            QString generatedId = QString("cam%1").arg(m_configs.size() + 1);
+            qWarning() << "Camera config" << m_configs.size() << "has a missing or duplicate id"
+                       << config.id << "- using" << generatedId;
+            config.id = generatedId;
+        }
+        usedIds.insert(config.id);
+        
         // Add ALL cameras to maintain correct indexing (disabled ones too)
         m_configs.append(config);
         qDebug() << "Loaded camera config" << m_configs.size()-1 << ":" 
                  << config.id << config.name << config.type << config.source 
                  << "enabled:" << config.enabled;
-        
-        // Stop after 4 cameras
-        if (m_configs.size() >= 4) break;
     }
 
     qDebug() << "Total cameras in config:" << m_configs.size();
@@ -154,52 +252,56 @@ bool CameraManager::loadConfiguration(const QString &configPath)
 
 void CameraManager::createCameraStreams()
 {
+    beginResetModel();
+    
     // Clear existing cameras
     qDeleteAll(m_cameras);
     m_cameras.clear();
+    m_cameraById.clear();
+    m_cameraInfos.clear();
 
-    // Always create exactly 4 slots
-    // Process configs but maintain order - cam1 always slot 0, cam2 slot 1, etc.
-    for (int i = 0; i < 4; i++) {
+    // One slot per config, in config order - disabled cameras keep a nullptr slot
+    for (const CameraConfig &config : m_configs) {
         CameraStream *stream = nullptr;
         
-        // Find config for this slot (if exists and enabled)
-        if (i < m_configs.size()) {
-            const CameraConfig &config = m_configs[i];
+        if (config.enabled) {
+            // Create camera stream (id, source, sourceType, name); its analysis
+            // stages run on the shared pipeline executor
+            stream = new CameraStream(
+                config.id,
+                config.source,
+                config.type,
+                config.name,
+                m_executor.get(),
+                this
+            );
             
-            if (config.enabled) {
-                // Create camera stream with new constructor (id, source, sourceType, name)
-                stream = new CameraStream(
-                    config.id,
-                    config.source,
-                    config.type,
-                    config.name,
-                    this
-                );
-                
-                // Set ROI if available
-                if (config.hasRoi && !config.roiPoints.isEmpty()) {
-                    stream->setRoiPolygon(config.roiPoints);
-                }
-                
-                // Set Tripwire if available
-                if (config.hasTripwire) {
-                    stream->setTripwire(config.tripwireStart, config.tripwireEnd);
-                }
-                
-                // Set ObjectDetector
-                if (m_detector) {
-                    stream->setObjectDetector(m_detector.get());
-                }
+            // Set ROI if available
+            if (config.hasRoi && !config.roiPoints.isEmpty()) {
+                stream->setRoiPolygon(config.roiPoints);
             }
+            
+            // Set Tripwire if available
+            if (config.hasTripwire) {
+                stream->setTripwire(config.tripwireStart, config.tripwireEnd);
+            }
+            
+            // Set ObjectDetector
+            if (m_detector) {
+                stream->setObjectDetector(m_detector.get());
+            }
+            
+            m_cameraById.insert(config.id, stream);
+            m_cameraInfos.append({ config.id, config.name, config.type, config.source });
         }
         
         m_cameras.append(stream);
     }
     
-    int enabledCount = std::count_if(m_cameras.begin(), m_cameras.end(), 
-                                      [](CameraStream* s) { return s != nullptr; });
-    qDebug() << "Created 4 camera slots," << enabledCount << "enabled";
+    endResetModel();
+    emit countChanged();
+    
+    qDebug() << "Created" << m_cameras.size() << "camera slots," << m_cameraById.size() << "enabled";
     
     // Debug: show what's in each slot
     for (int i = 0; i < m_cameras.size(); i++) {
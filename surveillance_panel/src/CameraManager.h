@@ -1,12 +1,14 @@
 #ifndef CAMERAMANAGER_H
 #define CAMERAMANAGER_H
 
-#include <QObject>
+#include <QAbstractListModel>
 #include <QString>
 #include <QVector>
+#include <QHash>
 #include <memory>
 #include "CameraStream.h"
 #include "ObjectDetector.h"
+#include "PipelineExecutor.h"
 
 // Forward declaration
 class CameraImageProvider;
@@ -28,29 +30,58 @@ struct CameraConfig {
 };
 
 /**
- * @brief Manages multiple camera streams and their configuration
+ * @brief Identity of an enabled camera, for readers on other threads
  */
-class CameraManager : public QObject
+struct CameraInfo {
+    QString id;
+    QString name;
+    QString type;
+    QString source;
+};
+
+/**
+ * @brief Manages any number of camera streams and their configuration
+ *
+ * Exposed to QML as a list model (one row per configured camera, disabled
+ * ones included) so views can bind with a GridView/Repeater. The index
+ * based invokables below use 1-based indices, matching model.cameraIndex.
+ */
+class CameraManager : public QAbstractListModel
 {
     Q_OBJECT
-    
-    // Expose individual camera streams as properties
-    Q_PROPERTY(QObject* camera1 READ camera1 CONSTANT)
-    Q_PROPERTY(QObject* camera2 READ camera2 CONSTANT)
-    Q_PROPERTY(QObject* camera3 READ camera3 CONSTANT)
-    Q_PROPERTY(QObject* camera4 READ camera4 CONSTANT)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
 
 public:
+    enum CameraRoles {
+        CameraIdRole = Qt::UserRole + 1,
+        CameraIndexRole,
+        NameRole,
+        TypeRole,
+        SourceRole,
+        AvailableRole,
+        StreamRole
+    };
+
     explicit CameraManager(QObject *parent = nullptr);
     ~CameraManager();
 
-    // Property getters
-    QObject* camera1() const { return m_cameras.value(0, nullptr); }
-    QObject* camera2() const { return m_cameras.value(1, nullptr); }
-    QObject* camera3() const { return m_cameras.value(2, nullptr); }
-    QObject* camera4() const { return m_cameras.value(3, nullptr); }
+    // QAbstractListModel interface
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Registry lookups. The registry is built once at startup and not modified
+    // afterwards, so these are safe to call from any thread.
+    CameraStream *cameraById(const QString &cameraId) const;
+    QVector<CameraStream*> cameras() const;
+    QVector<CameraInfo> cameraInfos() const { return m_cameraInfos; }
+    
+    // Shared by every camera; null if no model is configured
+    const ObjectDetector *detector() const { return m_detector.get(); }
 
     // Invokable methods for QML
+    Q_INVOKABLE QObject *camera(int index) const;
+    Q_INVOKABLE QString cameraId(int index) const;
     Q_INVOKABLE QString cameraName(int index) const;
     Q_INVOKABLE bool cameraAvailable(int index) const;
     Q_INVOKABLE QString cameraType(int index) const;
@@ -69,6 +100,7 @@ public:
     Q_INVOKABLE void clearTripwire(int index);
 
 signals:
+    void countChanged();
     void roiChanged(int index);
     void tripwireChanged(int index);
 
@@ -79,8 +111,11 @@ private:
 
     QString m_configPath;
     QVector<CameraConfig> m_configs;
-    QVector<CameraStream*> m_cameras;  // Up to 4 cameras
+    QVector<CameraStream*> m_cameras;              // One slot per config, nullptr if disabled
+    QHash<QString, CameraStream*> m_cameraById;    // Registry by camera ID
+    QVector<CameraInfo> m_cameraInfos;             // Enabled cameras in config order
     std::unique_ptr<ObjectDetector> m_detector;
+    std::unique_ptr<PipelineExecutor> m_executor;  // Outlives the streams (deleted in the destructor body)
 };
 
 #endif // CAMERAMANAGER_H
\ No newline at end of file
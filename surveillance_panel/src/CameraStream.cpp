@@ -3,6 +3,45 @@
 #include <QDateTime>
 #include <QDir>
 #include <QRegularExpression>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QElapsedTimer>
+
+// ============================================================================
+// FrameMailbox Implementation
+// ============================================================================
+
+FrameMailbox::FrameMailbox()
+    : m_wakeupPending(false)
+    , m_droppedFrames(0)
+{
+}
+
+bool FrameMailbox::post(const QImage &frame)
+{
+    QMutexLocker locker(&m_mutex);
+    
+    if (!m_frame.isNull()) {
+        // Consumer did not pick up the previous frame in time
+        m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_frame = frame;
+    
+    const bool needsWakeup = !m_wakeupPending;
+    m_wakeupPending = true;
+    return needsWakeup;
+}
+
+QImage FrameMailbox::take()
+{
+    QImage frame;
+    
+    QMutexLocker locker(&m_mutex);
+    frame.swap(m_frame);
+    m_wakeupPending = false;
+    
+    return frame;
+}
 
 // ============================================================================
 // CaptureWorker Implementation
@@ -16,22 +55,10 @@ CaptureWorker::CaptureWorker(int cameraIndex)
     , m_lastFrameTime(0)
     , m_frameCount(0)
     , m_currentFps(0.0)
-    , m_motionEnabled(false)
-    , m_motionSensitivity(50.0)
-    , m_lastMotionTime(0)
-    , m_hasRoi(false)
-    , m_lastRoiAlertTime(0)
-    , m_hasTripwire(false)
-    , m_lastTripwireAlertTime(0)
-    , m_prevSide(0.0)
-    , m_hasPrevSide(false)
-    , m_detector(nullptr)
-    , m_aiEnabled(false)
-    , m_aiFrameCounter(0)
-    , m_nextTrackId(1)
+    , m_analyzer(nullptr)
+    , m_droppedAnalysisFrames(0)
+    , m_clipRecorder(nullptr)
 {
-    // Create background subtractor for motion detection
-    m_backgroundSubtractor = cv::createBackgroundSubtractorMOG2(500, 16, false);
 }
 
 CaptureWorker::~CaptureWorker()
@@ -53,6 +80,12 @@ void CaptureWorker::setSourceUrl(const QString &url)
     m_cameraIndex = -1;
 }
 
+void CaptureWorker::setAnalysisStage(FrameAnalyzer *analyzer, std::shared_ptr<PipelineStrand> strand)
+{
+    m_analyzer = analyzer;
+    m_strand = std::move(strand);
+}
+
 void CaptureWorker::start()
 {
     if (m_running) {
@@ -114,26 +147,20 @@ void CaptureWorker::captureFrame()
     }
 
     cv::Mat frame;
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
     m_capture >> frame;
+    if (m_metrics) {
+        m_metrics->decode.observe(decodeTimer.nsecsElapsed());
+    }
 
     if (frame.empty()) {
         emit errorOccurred("Failed to capture frame");
         return;
     }
 
-    // Process motion detection if enabled
-    if (m_motionEnabled) {
-        processMotionDetection(frame);
-    }
-    
-    // Process AI detection if enabled (every N frames)
-    if (m_aiEnabled.load(std::memory_order_relaxed) && m_detector && m_detector->isLoaded()) {
-        m_aiFrameCounter++;
-        if (m_aiFrameCounter >= AI_PROCESS_INTERVAL) {
-            m_aiFrameCounter = 0;
-            processAIDetection(frame);
-        }
-    }
+    // The clip buffer and event clips share this clock
+    const qint64 capturedMs = QDateTime::currentMSecsSinceEpoch();
 
     // Convert BGR to RGB
     cv::Mat rgbFrame;
@@ -149,7 +176,36 @@ void CaptureWorker::captureFrame()
     // Deep copy to ensure data persists after cv::Mat is destroyed
     QImage imageCopy = qImg.copy();
 
-    emit frameCaptured(imageCopy);
+    // Hand the frame over through the mailbox; only post a wakeup if the
+    // GUI thread has not been notified yet, so stalls never queue frames
+    if (m_mailbox.post(imageCopy)) {
+        emit frameAvailable();
+    }
+
+    // Pre-event buffer; compression happens on the recorder's strand
+    if (m_clipRecorder) {
+        m_clipRecorder->addFrame(frame, capturedMs);
+    }
+
+    // Queue analysis on the shared pool. The strand keeps this camera's
+    // frames in order; a full backlog means the pool is saturated, so the
+    // frame is skipped rather than queued.
+    if (m_analyzer && m_strand && m_analyzer->isActive()) {
+        if (m_strand->backlog() < MAX_ANALYSIS_BACKLOG) {
+            FrameAnalyzer *analyzer = m_analyzer;
+            // imageCopy is implicitly shared with the mailbox, so events
+            // can reference the exact frame without another copy
+            m_strand->post([analyzer, frame, imageCopy, capturedMs]() {
+                analyzer->analyzeFrame(frame, imageCopy, capturedMs);
+            });
+        } else {
+            m_droppedAnalysisFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (m_metrics) {
+        m_metrics->framesCaptured.fetch_add(1, std::memory_order_relaxed);
+    }
 
     // Calculate FPS
     m_frameCount++;
@@ -159,6 +215,9 @@ void CaptureWorker::captureFrame()
         
         if (elapsed > 0) {
             m_currentFps = (m_frameCount * 1000.0) / elapsed;
+            if (m_metrics) {
+                m_metrics->captureFps.store(m_currentFps, std::memory_order_relaxed);
+            }
             emit fpsUpdated(m_currentFps);
         }
         
@@ -167,7 +226,66 @@ void CaptureWorker::captureFrame()
     }
 }
 
-void CaptureWorker::processAIDetection(const cv::Mat &frame)
+// ============================================================================
+// FrameAnalyzer Implementation
+// ============================================================================
+
+FrameAnalyzer::FrameAnalyzer(QObject *parent)
+    : QObject(parent)
+    , m_eventFrameMs(0)
+    , m_motionEnabled(false)
+    , m_motionSensitivity(50.0)
+    , m_lastMotionTime(0)
+    , m_hasRoi(false)
+    , m_lastRoiAlertTime(0)
+    , m_hasTripwire(false)
+    , m_lastTripwireAlertTime(0)
+    , m_prevSide(0.0)
+    , m_hasPrevSide(false)
+    , m_detector(nullptr)
+    , m_aiEnabled(false)
+    , m_aiFrameCounter(0)
+    , m_nextTrackId(1)
+{
+    // Create background subtractor for motion detection
+    m_backgroundSubtractor = cv::createBackgroundSubtractorMOG2(500, 16, false);
+}
+
+bool FrameAnalyzer::isActive() const
+{
+    return m_motionEnabled.load(std::memory_order_relaxed) ||
+           m_aiEnabled.load(std::memory_order_relaxed);
+}
+
+void FrameAnalyzer::analyzeFrame(const cv::Mat &frame, const QImage &image, qint64 capturedMs)
+{
+    m_eventFrame = image;
+    m_eventFrameMs = capturedMs;
+
+    // Process motion detection if enabled
+    if (m_motionEnabled.load(std::memory_order_relaxed)) {
+        QElapsedTimer timer;
+        timer.start();
+        processMotionDetection(frame);
+        if (m_metrics) {
+            m_metrics->motion.observe(timer.nsecsElapsed());
+        }
+    }
+    
+    // Process AI detection if enabled (every N frames)
+    if (m_aiEnabled.load(std::memory_order_relaxed) && m_detector && m_detector->isLoaded()) {
+        m_aiFrameCounter++;
+        if (m_aiFrameCounter >= AI_PROCESS_INTERVAL) {
+            m_aiFrameCounter = 0;
+            processAIDetection(frame);
+        }
+    }
+
+    // Drop the reference so the frame is freed once the GUI moves on
+    m_eventFrame = QImage();
+}
+
+void FrameAnalyzer::processAIDetection(const cv::Mat &frame)
 {
     if (!m_detector || !m_detector->isLoaded()) {
         return;
@@ -175,10 +293,20 @@ void CaptureWorker::processAIDetection(const cv::Mat &frame)
     
     try {
         // Run inference
+        QElapsedTimer timer;
+        timer.start();
         std::vector<Detection> detections = m_detector->infer(frame);
+        if (m_metrics) {
+            m_metrics->inference.observe(timer.nsecsElapsed());
+        }
         
         // Update tracks with new detections
+        timer.restart();
         updateTracks(detections, frame.cols, frame.rows);
+        if (m_metrics) {
+            m_metrics->postProcess.observe(timer.nsecsElapsed());
+            m_metrics->activeTracks.store(static_cast<int>(m_tracks.size()), std::memory_order_relaxed);
+        }
         
         // Emit detections to main thread
         emit aiDetectionsReady(detections);
@@ -188,26 +316,26 @@ void CaptureWorker::processAIDetection(const cv::Mat &frame)
     }
 }
 
-void CaptureWorker::setAiEnabled(bool enabled)
+void FrameAnalyzer::setAiEnabled(bool enabled)
 {
     m_aiEnabled.store(enabled, std::memory_order_relaxed);
     m_aiFrameCounter = 0;
     qDebug() << "AI detection worker state:" << (enabled ? "enabled" : "disabled");
 }
 
-void CaptureWorker::setAiConfidenceThreshold(double threshold)
+void FrameAnalyzer::setAiConfidenceThreshold(double threshold)
 {
     if (m_detector) {
         m_detector->setConfidenceThreshold(static_cast<float>(threshold));
     }
 }
 
-void CaptureWorker::setObjectDetector(ObjectDetector *detector)
+void FrameAnalyzer::setObjectDetector(ObjectDetector *detector)
 {
     m_detector = detector;
 }
 
-void CaptureWorker::processMotionDetection(const cv::Mat &frame)
+void FrameAnalyzer::processMotionDetection(const cv::Mat &frame)
 {
     // Apply background subtractor
     cv::Mat fgMask;
@@ -234,7 +362,7 @@ void CaptureWorker::processMotionDetection(const cv::Mat &frame)
         qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
         if (currentTime - m_lastMotionTime > 2000) {
             m_lastMotionTime = currentTime;
-            emit motionDetected(motionScore, frame.clone());
+            emit motionDetected(motionScore, m_eventFrame, m_eventFrameMs);
         }
     }
     
@@ -249,7 +377,7 @@ void CaptureWorker::processMotionDetection(const cv::Mat &frame)
     }
 }
 
-void CaptureWorker::processRoiMotion(const cv::Mat &motionMask, int width, int height)
+void FrameAnalyzer::processRoiMotion(const cv::Mat &motionMask, int width, int height)
 {
     // Convert normalized ROI points to pixel coordinates
     std::vector<cv::Point> roiPts;
@@ -290,14 +418,12 @@ void CaptureWorker::processRoiMotion(const cv::Mat &motionMask, int width, int h
         if (currentTime - m_lastRoiAlertTime > 3000) {
             m_lastRoiAlertTime = currentTime;
             
-            // We need the original frame for snapshot, but we only have the mask here
-            // We'll pass an empty Mat and let the main thread handle snapshot
-            emit roiMotionDetected(roiScore, cv::Mat());
+            emit roiMotionDetected(roiScore, m_eventFrame, m_eventFrameMs);
         }
     }
 }
 
-void CaptureWorker::processTripwire(const cv::Mat &motionMask, int width, int height)
+void FrameAnalyzer::processTripwire(const cv::Mat &motionMask, int width, int height)
 {
     // Compute centroid of motion
     cv::Moments m = cv::moments(motionMask, true);
@@ -336,7 +462,7 @@ void CaptureWorker::processTripwire(const cv::Mat &motionMask, int width, int he
                 // Determine direction
                 int direction = (curSide > 0 && m_prevSide < 0) ? 1 : -1;
                 
-                emit tripwireCrossed(direction, cv::Mat());
+                emit tripwireCrossed(direction, m_eventFrame, m_eventFrameMs);
             }
         }
     }
@@ -345,21 +471,21 @@ void CaptureWorker::processTripwire(const cv::Mat &motionMask, int width, int he
     m_hasPrevSide = true;
 }
 
-void CaptureWorker::setRoiPolygon(const QVector<QPointF> &normalizedPoints)
+void FrameAnalyzer::setRoiPolygon(const QVector<QPointF> &normalizedPoints)
 {
     m_roiNorm = normalizedPoints;
     m_hasRoi = !m_roiNorm.isEmpty();
     m_lastRoiAlertTime = 0;
 }
 
-void CaptureWorker::clearRoi()
+void FrameAnalyzer::clearRoi()
 {
     m_roiNorm.clear();
     m_hasRoi = false;
     m_lastRoiAlertTime = 0;
 }
 
-void CaptureWorker::setTripwire(const QPointF &startNorm, const QPointF &endNorm)
+void FrameAnalyzer::setTripwire(const QPointF &startNorm, const QPointF &endNorm)
 {
     m_tripwireStartNorm = startNorm;
     m_tripwireEndNorm = endNorm;
@@ -368,7 +494,7 @@ void CaptureWorker::setTripwire(const QPointF &startNorm, const QPointF &endNorm
     m_hasPrevSide = false;
 }
 
-void CaptureWorker::clearTripwire()
+void FrameAnalyzer::clearTripwire()
 {
     m_tripwireStartNorm = QPointF();
     m_tripwireEndNorm = QPointF();
@@ -377,7 +503,7 @@ void CaptureWorker::clearTripwire()
     m_hasPrevSide = false;
 }
 
-void CaptureWorker::updateTracks(const std::vector<Detection> &detections, int frameWidth, int frameHeight)
+void FrameAnalyzer::updateTracks(const std::vector<Detection> &detections, int frameWidth, int frameHeight)
 {
     qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
     
@@ -492,7 +618,7 @@ void CaptureWorker::updateTracks(const std::vector<Detection> &detections, int f
     }
 }
 
-void CaptureWorker::cleanupStaleTracks(qint64 currentTime)
+void FrameAnalyzer::cleanupStaleTracks(qint64 currentTime)
 {
     // Remove tracks not seen for TRACK_TIMEOUT_MS
     QList<int> toRemove;
@@ -508,7 +634,7 @@ void CaptureWorker::cleanupStaleTracks(qint64 currentTime)
     }
 }
 
-void CaptureWorker::logTracks() const
+void FrameAnalyzer::logTracks() const
 {
     QStringList trackInfo;
     
@@ -532,7 +658,7 @@ void CaptureWorker::logTracks() const
     }
 }
 
-double CaptureWorker::computeSideOfLine(const QPointF &point) const
+double FrameAnalyzer::computeSideOfLine(const QPointF &point) const
 {
     // Compute cross product: (p.x - x1)*(y2 - y1) - (p.y - y1)*(x2 - x1)
     // where line goes from (x1, y1) to (x2, y2)
@@ -545,7 +671,7 @@ double CaptureWorker::computeSideOfLine(const QPointF &point) const
     return side;
 }
 
-QString CaptureWorker::getCrossingDirection(double prevSide, double currSide) const
+QString FrameAnalyzer::getCrossingDirection(double prevSide, double currSide) const
 {
     // prevSide < 0 and currSide > 0 means crossing from negative side to positive side
     // prevSide > 0 and currSide < 0 means crossing from positive side to negative side
@@ -559,7 +685,7 @@ QString CaptureWorker::getCrossingDirection(double prevSide, double currSide) co
     return "unknown";
 }
 
-void CaptureWorker::checkLineCrossing(TrackState &track, qint64 currentTime)
+void FrameAnalyzer::checkLineCrossing(TrackState &track, qint64 currentTime)
 {
     // Only check if track has a valid previous centroid
     // (skip on first detection of track when prev == curr)
@@ -591,12 +717,11 @@ void CaptureWorker::checkLineCrossing(TrackState &track, qint64 currentTime)
         // Update debounce timestamp
         track.lastTripwireAlertMs = currentTime;
         
-        // Emit signal with empty frame (we don't have it here, will get from captureFrame)
-        emit trackCrossedTripwire(track.id, track.label, direction, cv::Mat());
+        emit trackCrossedTripwire(track.id, track.label, direction, m_eventFrame, m_eventFrameMs);
     }
 }
 
-bool CaptureWorker::pointInRoi(const QPointF &point) const
+bool FrameAnalyzer::pointInRoi(const QPointF &point) const
 {
     // If no ROI defined, return false
     if (!m_hasRoi || m_roiNorm.size() < 3) {
@@ -622,7 +747,7 @@ bool CaptureWorker::pointInRoi(const QPointF &point) const
     return inside;
 }
 
-void CaptureWorker::updateRoiStatus(TrackState &track, qint64 currentTime)
+void FrameAnalyzer::updateRoiStatus(TrackState &track, qint64 currentTime)
 {
     // Check if track is currently inside ROI
     bool nowInside = pointInRoi(track.centroid);
@@ -649,7 +774,7 @@ void CaptureWorker::updateRoiStatus(TrackState &track, qint64 currentTime)
     track.insideRoi = nowInside;
 }
 
-void CaptureWorker::checkLoitering(TrackState &track, qint64 currentTime)
+void FrameAnalyzer::checkLoitering(TrackState &track, qint64 currentTime)
 {
     // Only check if track is inside ROI
     if (!track.insideRoi) {
@@ -672,7 +797,7 @@ void CaptureWorker::checkLoitering(TrackState &track, qint64 currentTime)
         track.loiterAlertSent = true;
         
         // Emit loitering signal
-        emit loiteringDetected(track.id, track.label, durationMs, cv::Mat());
+        emit loiteringDetected(track.id, track.label, durationMs, m_eventFrame, m_eventFrameMs);
     }
 }
 
@@ -680,13 +805,16 @@ void CaptureWorker::checkLoitering(TrackState &track, qint64 currentTime)
 // CameraStream Implementation
 // ============================================================================
 
-CameraStream::CameraStream(const QString &id, const QString &source, const QString &sourceType, const QString &name, QObject *parent)
+CameraStream::CameraStream(const QString &id, const QString &source, const QString &sourceType, const QString &name,
+                           PipelineExecutor *executor, QObject *parent)
     : QObject(parent)
     , m_id(id)
     , m_source(source)
     , m_sourceType(sourceType)
+    , m_frameSequence(0)
     , m_running(false)
     , m_fps(0.0)
+    , m_droppedFrames(0)
     , m_status("Stopped")
     , m_cameraName(name)
     , m_cameraIndex(-1)
@@ -711,9 +839,14 @@ CameraStream::CameraStream(const QString &id, const QString &source, const QStri
     , m_aiConfidenceThreshold(0.5)
     , m_workerThread(nullptr)
     , m_worker(nullptr)
+    , m_analyzer(nullptr)
     , m_autoSnapshotOnMotion(false)
     , m_autoSnapshotOnRoi(false)
     , m_autoSnapshotOnTripwire(false)
+    , m_clipFlushTimer(nullptr)
+    , m_notifyTimer(nullptr)
+    , m_pendingNotifications(0)
+    , m_uiRefreshRate(DEFAULT_UI_REFRESH_RATE)
 {
     // Determine source type and configure worker
     if (m_sourceType == "usb" || m_source.toInt() >= 0) {
@@ -724,9 +857,45 @@ CameraStream::CameraStream(const QString &id, const QString &source, const QStri
         m_isUrlSource = true;
     }
     
-    // Create worker thread
+    // Analysis runs on the shared pool, serialized through this camera's strand
+    m_analyzer = new FrameAnalyzer();
+    m_strand = executor->createStrand();
+    
+    // Create capture thread - decoding blocks on I/O, so it keeps its own thread
     m_workerThread = new QThread(this);
     m_worker = new CaptureWorker(m_cameraIndex);
+    m_worker->setAnalysisStage(m_analyzer, m_strand);
+    
+    m_metrics = std::make_shared<CameraMetrics>();
+    m_worker->setMetrics(m_metrics);
+    m_analyzer->setMetrics(m_metrics);
+    
+    // Event clips get a strand of their own so compression never delays analysis
+    m_clipRecorder = std::make_unique<EventClipRecorder>(executor->createStrand(), m_id);
+    m_worker->setClipRecorder(m_clipRecorder.get());
+    
+    // Clips finish on a pool thread; the stream may be gone by then
+    QPointer<CameraStream> self(this);
+    m_clipRecorder->setClipCallback([self](const QString &filePath, bool success) {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self, filePath, success]() {
+            if (!self) {
+                return;
+            }
+            if (success) {
+                emit self->eventClipSaved(filePath);
+            } else {
+                emit self->eventClipFailed(filePath);
+            }
+        }, Qt::QueuedConnection);
+    });
+    
+    // Clips normally finish as their post-roll is captured; this catches
+    // those left waiting by a camera that stopped delivering frames
+    m_clipFlushTimer = new QTimer(this);
+    m_clipFlushTimer->setInterval(CLIP_FLUSH_INTERVAL_MS);
+    connect(m_clipFlushTimer, &QTimer::timeout,
+            this, &CameraStream::flushOverdueClips);
+    m_clipFlushTimer->start();
     
     // Set source on worker
     if (m_isUrlSource) {
@@ -736,24 +905,26 @@ CameraStream::CameraStream(const QString &id, const QString &source, const QStri
     m_worker->moveToThread(m_workerThread);
 
     // Connect signals
-    connect(m_worker, &CaptureWorker::frameCaptured, 
-            this, &CameraStream::onFrameCaptured);
+    connect(m_worker, &CaptureWorker::frameAvailable, 
+            this, &CameraStream::onFrameAvailable);
     connect(m_worker, &CaptureWorker::fpsUpdated, 
             this, &CameraStream::onFpsUpdated);
     connect(m_worker, &CaptureWorker::errorOccurred, 
             this, &CameraStream::onErrorOccurred);
-    connect(m_worker, &CaptureWorker::motionDetected,
-            this, &CameraStream::onMotionDetected);
-    connect(m_worker, &CaptureWorker::roiMotionDetected,
-            this, &CameraStream::onRoiMotionDetected);
-    connect(m_worker, &CaptureWorker::tripwireCrossed,
-            this, &CameraStream::onTripwireCrossed);
-    connect(m_worker, &CaptureWorker::trackCrossedTripwire,
-            this, &CameraStream::onTrackCrossedTripwire);
-    connect(m_worker, &CaptureWorker::loiteringDetected,
-            this, &CameraStream::onLoiteringDetected);
-    connect(m_worker, &CaptureWorker::aiDetectionsReady,
-            this, &CameraStream::onAIDetectionsReady);
+    
+    // Analyzer signals are emitted from pool threads
+    connect(m_analyzer, &FrameAnalyzer::motionDetected,
+            this, &CameraStream::onMotionDetected, Qt::QueuedConnection);
+    connect(m_analyzer, &FrameAnalyzer::roiMotionDetected,
+            this, &CameraStream::onRoiMotionDetected, Qt::QueuedConnection);
+    connect(m_analyzer, &FrameAnalyzer::tripwireCrossed,
+            this, &CameraStream::onTripwireCrossed, Qt::QueuedConnection);
+    connect(m_analyzer, &FrameAnalyzer::trackCrossedTripwire,
+            this, &CameraStream::onTrackCrossedTripwire, Qt::QueuedConnection);
+    connect(m_analyzer, &FrameAnalyzer::loiteringDetected,
+            this, &CameraStream::onLoiteringDetected, Qt::QueuedConnection);
+    connect(m_analyzer, &FrameAnalyzer::aiDetectionsReady,
+            this, &CameraStream::onAIDetectionsReady, Qt::QueuedConnection);
 
     // Connect thread cleanup
     connect(m_workerThread, &QThread::finished, 
@@ -779,6 +950,14 @@ CameraStream::CameraStream(const QString &id, const QString &source, const QStri
     m_tripwireAlertResetTimer->setInterval(2000);
     connect(m_tripwireAlertResetTimer, &QTimer::timeout,
             this, &CameraStream::resetTripwireAlertActive);
+    
+    // Create notification timer - worker-driven property changes are collected
+    // and emitted together at most once per UI refresh interval
+    m_notifyTimer = new QTimer(this);
+    m_notifyTimer->setSingleShot(true);
+    m_notifyTimer->setInterval(1000 / m_uiRefreshRate);
+    connect(m_notifyTimer, &QTimer::timeout,
+            this, &CameraStream::flushNotifications);
 
     // Start the thread
     m_workerThread->start();
@@ -792,6 +971,18 @@ CameraStream::~CameraStream()
         m_workerThread->quit();
         m_workerThread->wait();
     }
+    
+    // Capture has stopped posting; wait out any analysis still running on the pool
+    if (m_strand) {
+        m_strand->shutdown();
+    }
+    
+    // The callback cannot reach this stream any more; report what will never be written
+    for (const QString &filePath : m_clipRecorder->discardPendingClips()) {
+        emit eventClipFailed(filePath);
+    }
+    m_clipRecorder->shutdown();
+    delete m_analyzer;
 }
 
 void CameraStream::start()
@@ -826,6 +1017,30 @@ void CameraStream::stop()
     QMetaObject::invokeMethod(m_worker, "stop", Qt::QueuedConnection);
 }
 
+void CameraStream::setEventClipsEnabled(bool enabled)
+{
+    if (m_clipRecorder->isEnabled() != enabled) {
+        m_clipRecorder->setEnabled(enabled);
+        emit eventClipsEnabledChanged();
+        qDebug() << "Event clips:" << enabled << "for camera:" << m_cameraName;
+    }
+}
+
+void CameraStream::setEventClipDirectory(const QString &dirPath)
+{
+    m_clipRecorder->setOutputDirectory(dirPath);
+}
+
+QString CameraStream::recordEventClip(qint64 eventTimeMs)
+{
+    return m_clipRecorder->requestClip(eventTimeMs);
+}
+
+void CameraStream::flushOverdueClips()
+{
+    m_clipRecorder->flushOverdueClips(QDateTime::currentMSecsSinceEpoch());
+}
+
 void CameraStream::setAutoSnapshotOnMotion(bool enabled)
 {
     if (m_autoSnapshotOnMotion != enabled) {
@@ -894,26 +1109,117 @@ void CameraStream::setSourceUrl(const QString &url)
     }
 }
 
-void CameraStream::onFrameCaptured(const QImage &frame)
+void CameraStream::onFrameAvailable()
 {
-    QMutexLocker locker(&m_frameMutex);
-    m_currentFrame = frame;
-    m_status = "Running";
-    emit frameChanged();
-    emit statusChanged();
+    QImage frame = m_worker->mailbox()->take();
+    if (frame.isNull()) {
+        return;
+    }
+    
+    {
+        QMutexLocker locker(&m_frameMutex);
+        m_currentFrame = frame;
+        ++m_frameSequence;
+    }
+    
+    setStatus("Running");
+    scheduleNotification(NotifyFrame);
+    
+    quint64 dropped = m_worker->mailbox()->droppedFrames();
+    if (dropped != m_droppedFrames) {
+        m_droppedFrames = dropped;
+        scheduleNotification(NotifyDroppedFrames);
+    }
 }
 
 void CameraStream::onFpsUpdated(double fps)
 {
+    if (qFuzzyCompare(m_fps, fps)) {
+        return;
+    }
+    
     m_fps = fps;
-    emit fpsChanged();
+    scheduleNotification(NotifyFps);
+}
+
+void CameraStream::postToAnalyzer(std::function<void(FrameAnalyzer*)> change)
+{
+    // Configuration goes through the same strand as the frames, so it applies
+    // between two frames and never races with a running analysis
+    FrameAnalyzer *analyzer = m_analyzer;
+    m_strand->post([analyzer, change]() {
+        change(analyzer);
+    });
+}
+
+void CameraStream::setUiRefreshRate(int rate)
+{
+    rate = qBound(1, rate, 120);
+    
+    if (m_uiRefreshRate == rate) {
+        return;
+    }
+    
+    m_uiRefreshRate = rate;
+    m_notifyTimer->setInterval(1000 / m_uiRefreshRate);
+    emit uiRefreshRateChanged();
+}
+
+void CameraStream::setStatus(const QString &status)
+{
+    if (m_status == status) {
+        return;
+    }
+    
+    m_status = status;
+    scheduleNotification(NotifyStatus);
+}
+
+void CameraStream::scheduleNotification(int flags)
+{
+    m_pendingNotifications |= flags;
+    
+    // The first change in an interval arms the timer; later ones just join the batch
+    if (!m_notifyTimer->isActive()) {
+        m_notifyTimer->start();
+    }
+}
+
+void CameraStream::flushNotifications()
+{
+    const int pending = m_pendingNotifications;
+    m_pendingNotifications = 0;
+    
+    if (pending & NotifyFrame) {
+        emit frameChanged();
+    }
+    if (pending & NotifyFps) {
+        emit fpsChanged();
+    }
+    if (pending & NotifyStatus) {
+        emit statusChanged();
+    }
+    if (pending & NotifyDetections) {
+        emit detectionsChanged();
+    }
+    if (pending & NotifyMotionActive) {
+        emit motionActiveChanged();
+    }
+    if (pending & NotifyRoiAlertActive) {
+        emit roiAlertActiveChanged();
+    }
+    if (pending & NotifyTripwireAlertActive) {
+        emit tripwireAlertActiveChanged();
+    }
+    if (pending & NotifyDroppedFrames) {
+        emit droppedFramesChanged();
+    }
 }
 
 void CameraStream::onErrorOccurred(const QString &error)
 {
     qWarning() << "CameraStream error:" << error;
-    m_status = QString("Error: %1").arg(error);
-    emit statusChanged();
+    setStatus(QString("Error: %1").arg(error));
     
     // Auto-stop on error
     if (m_running) {
@@ -976,9 +1282,10 @@ void CameraStream::setMotionEnabled(bool enabled)
     
     m_motionEnabled = enabled;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "setMotionEnabled", Qt::QueuedConnection,
-                              Q_ARG(bool, enabled));
+    // Update analyzer on its strand
+    postToAnalyzer([enabled](FrameAnalyzer *analyzer) {
+        analyzer->setMotionEnabled(enabled);
+    });
     
     emit motionEnabledChanged();
     
@@ -996,35 +1303,36 @@ void CameraStream::setMotionSensitivity(double sensitivity)
     
     m_motionSensitivity = sensitivity;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "setMotionSensitivity", Qt::QueuedConnection,
-                              Q_ARG(double, sensitivity));
+    // Update analyzer on its strand
+    postToAnalyzer([sensitivity](FrameAnalyzer *analyzer) {
+        analyzer->setMotionSensitivity(sensitivity);
+    });
     
     emit motionSensitivityChanged();
 }
 
-void CameraStream::onMotionDetected(double score, const cv::Mat &frame)
+void CameraStream::onMotionDetected(double score, const QImage &frame, qint64 frameTimeMs)
 {
-    Q_UNUSED(frame);
-    
     qDebug() << "Motion detected on" << m_cameraName << "- score:" << score;
     
     // Set motion active flag
-    m_motionActive = true;
-    emit motionActiveChanged();
+    if (!m_motionActive) {
+        m_motionActive = true;
+        scheduleNotification(NotifyMotionActive);
+    }
     
     // Restart the reset timer
     m_motionResetTimer->start();
     
     // Emit motion detected signal for alert system
-    emit motionDetected(score);
+    emit motionDetected(score, frame, frameTimeMs);
 }
 
 void CameraStream::resetMotionActive()
 {
     if (m_motionActive) {
         m_motionActive = false;
-        emit motionActiveChanged();
+        scheduleNotification(NotifyMotionActive);
     }
 }
 
@@ -1032,7 +1340,7 @@ void CameraStream::resetRoiAlertActive()
 {
     if (m_roiAlertActive) {
         m_roiAlertActive = false;
-        emit roiAlertActiveChanged();
+        scheduleNotification(NotifyRoiAlertActive);
     }
 }
 
@@ -1040,73 +1348,71 @@ void CameraStream::resetTripwireAlertActive()
 {
     if (m_tripwireAlertActive) {
         m_tripwireAlertActive = false;
-        emit tripwireAlertActiveChanged();
+        scheduleNotification(NotifyTripwireAlertActive);
     }
 }
 
-void CameraStream::onRoiMotionDetected(double score, const cv::Mat &frame)
+void CameraStream::onRoiMotionDetected(double score, const QImage &frame, qint64 frameTimeMs)
 {
-    Q_UNUSED(frame);
-    
     qDebug() << "ROI motion detected on" << m_cameraName << "- score:" << score;
     
     // Set ROI alert active flag
-    m_roiAlertActive = true;
-    emit roiAlertActiveChanged();
+    if (!m_roiAlertActive) {
+        m_roiAlertActive = true;
+        scheduleNotification(NotifyRoiAlertActive);
+    }
     
     // Restart the reset timer
     m_roiAlertResetTimer->start();
     
     // Emit ROI motion detected signal for alert system
-    emit roiMotionDetected(score);
+    emit roiMotionDetected(score, frame, frameTimeMs);
 }
 
-void CameraStream::onTripwireCrossed(int direction, const cv::Mat &frame)
+void CameraStream::onTripwireCrossed(int direction, const QImage &frame, qint64 frameTimeMs)
 {
-    Q_UNUSED(frame);
-    
     QString dirText = (direction > 0) ? "forward" : "backward";
     qDebug() << "Tripwire crossed on" << m_cameraName << "- direction:" << dirText;
     
     // Set tripwire alert active flag
-    m_tripwireAlertActive = true;
-    emit tripwireAlertActiveChanged();
+    if (!m_tripwireAlertActive) {
+        m_tripwireAlertActive = true;
+        scheduleNotification(NotifyTripwireAlertActive);
+    }
     
     // Restart the reset timer
     m_tripwireAlertResetTimer->start();
     
     // Emit tripwire crossed signal for alert system
-    emit tripwireCrossed(direction);
+    emit tripwireCrossed(direction, frame, frameTimeMs);
 }
 
-void CameraStream::onTrackCrossedTripwire(int trackId, const QString &label, const QString &direction, const cv::Mat &frame)
+void CameraStream::onTrackCrossedTripwire(int trackId, const QString &label, const QString &direction, const QImage &frame, qint64 frameTimeMs)
 {
-    Q_UNUSED(frame);
-    
     qDebug() << "Track" << trackId << "(" << label << ") crossed tripwire on" 
              << m_cameraName << "- direction:" << direction;
     
     // Set tripwire alert active flag
-    m_tripwireAlertActive = true;
-    emit tripwireAlertActiveChanged();
+    if (!m_tripwireAlertActive) {
+        m_tripwireAlertActive = true;
+        scheduleNotification(NotifyTripwireAlertActive);
+    }
     
     // Restart the reset timer
     m_tripwireAlertResetTimer->start();
     
     // Emit signal for alert system with full context
-    emit trackCrossedTripwire(trackId, label, direction);
+    emit trackCrossedTripwire(trackId, label, direction, frame, frameTimeMs);
 }
 
-void CameraStream::onLoiteringDetected(int trackId, const QString &label, qint64 durationMs, const cv::Mat &frame)
+void CameraStream::onLoiteringDetected(int trackId, const QString &label, qint64 durationMs, const QImage &frame, qint64 frameTimeMs)
 {
-    Q_UNUSED(frame);
-    
     double durationSec = durationMs / 1000.0;
     qDebug() << "Track" << trackId << "(" << label << ") loitering detected on"
              << m_cameraName << "- duration:" << durationSec << "seconds";
     
     // Emit signal for alert system
-    emit loiteringDetected(trackId, label, durationMs);
+    emit loiteringDetected(trackId, label, durationMs, frame, frameTimeMs);
 }
 
 void CameraStream::setRoiPolygon(const QVector<QPointF> &normalizedPoints)
@@ -1114,9 +1420,10 @@ void CameraStream::setRoiPolygon(const QVector<QPointF> &normalizedPoints)
     m_roiNorm = normalizedPoints;
     m_hasRoi = !m_roiNorm.isEmpty();
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "setRoiPolygon", Qt::QueuedConnection,
-                              Q_ARG(QVector<QPointF>, normalizedPoints));
+    // Update analyzer on its strand
+    postToAnalyzer([normalizedPoints](FrameAnalyzer *analyzer) {
+        analyzer->setRoiPolygon(normalizedPoints);
+    });
     
     qDebug() << "ROI set for" << m_cameraName << "with" << normalizedPoints.size() << "points";
 }
@@ -1126,8 +1433,10 @@ void CameraStream::clearRoi()
     m_roiNorm.clear();
     m_hasRoi = false;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "clearRoi", Qt::QueuedConnection);
+    // Update analyzer on its strand
+    postToAnalyzer([](FrameAnalyzer *analyzer) {
+        analyzer->clearRoi();
+    });
     
     qDebug() << "ROI cleared for" << m_cameraName;
 }
@@ -1138,9 +1447,10 @@ void CameraStream::setTripwire(const QPointF &startNorm, const QPointF &endNorm)
     m_tripwireEndNorm = endNorm;
     m_hasTripwire = true;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "setTripwire", Qt::QueuedConnection,
-                              Q_ARG(QPointF, startNorm), Q_ARG(QPointF, endNorm));
+    // Update analyzer on its strand
+    postToAnalyzer([startNorm, endNorm](FrameAnalyzer *analyzer) {
+        analyzer->setTripwire(startNorm, endNorm);
+    });
     
     qDebug() << "Tripwire set for" << m_cameraName;
 }
@@ -1151,8 +1461,10 @@ void CameraStream::clearTripwire()
     m_tripwireEndNorm = QPointF();
     m_hasTripwire = false;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "clearTripwire", Qt::QueuedConnection);
+    // Update analyzer on its strand
+    postToAnalyzer([](FrameAnalyzer *analyzer) {
+        analyzer->clearTripwire();
+    });
     
     qDebug() << "Tripwire cleared for" << m_cameraName;
 }
@@ -1165,9 +1477,10 @@ void CameraStream::setAiEnabled(bool enabled)
     
     m_aiEnabled = enabled;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "setAiEnabled", Qt::QueuedConnection,
-                              Q_ARG(bool, enabled));
+    // Update analyzer on its strand
+    postToAnalyzer([enabled](FrameAnalyzer *analyzer) {
+        analyzer->setAiEnabled(enabled);
+    });
     
     if (!enabled) {
         // Clear detections when AI is disabled
@@ -1192,9 +1505,10 @@ void CameraStream::setAiConfidenceThreshold(double threshold)
     
     m_aiConfidenceThreshold = threshold;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "setAiConfidenceThreshold", Qt::QueuedConnection,
-                              Q_ARG(double, threshold));
+    // Update analyzer on its strand
+    postToAnalyzer([threshold](FrameAnalyzer *analyzer) {
+        analyzer->setAiConfidenceThreshold(threshold);
+    });
     
     emit aiConfidenceThresholdChanged();
 }
@@ -1203,9 +1517,10 @@ void CameraStream::setObjectDetector(ObjectDetector *detector)
 {
     m_detector = detector;
     
-    // Update worker on its thread
-    QMetaObject::invokeMethod(m_worker, "setObjectDetector", Qt::QueuedConnection,
-                              Q_ARG(ObjectDetector*, detector));
+    // Update analyzer on its strand
+    postToAnalyzer([detector](FrameAnalyzer *analyzer) {
+        analyzer->setObjectDetector(detector);
+    });
     
     if (m_detector) {
         m_detector->setConfidenceThreshold(static_cast<float>(m_aiConfidenceThreshold));
@@ -1264,5 +1579,5 @@ void CameraStream::onAIDetectionsReady(const std::vector<Detection> &detections)
         QMutexLocker locker(&m_detectionMutex);
         m_currentDetections = detections;
     }
-    emit detectionsChanged();
+    scheduleNotification(NotifyDetections);
 }
\ No newline at end of file
@@ -10,7 +10,11 @@
 #include <opencv2/opencv.hpp>
 #include <atomic>
 #include <memory>
+#include <functional>
 #include "ObjectDetector.h"
+#include "PipelineExecutor.h"
+#include "EventClipRecorder.h"
+#include "PipelineMetrics.h"
 
 /**
  * @brief Lightweight tracking state for a single detected object
@@ -39,28 +43,56 @@ struct TrackState {
 };
 
 /**
- * @brief Worker thread class that handles OpenCV camera capture
+ * @brief Single-slot, latest-only frame handoff from the capture thread to the GUI thread
+ *
+ * The producer overwrites any frame the consumer has not picked up yet, so a
+ * stalled GUI thread holds at most one pending frame per camera.
  */
-class CaptureWorker : public QObject
+class FrameMailbox
+{
+public:
+    FrameMailbox();
+
+    // Stores a frame, replacing (and counting as dropped) any unconsumed one.
+    // Returns true if the consumer has no wakeup pending and must be notified.
+    bool post(const QImage &frame);
+
+    // Takes the pending frame (null if none) and re-arms the wakeup
+    QImage take();
+
+    quint64 droppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+private:
+    QMutex m_mutex;
+    QImage m_frame;
+    bool m_wakeupPending;
+    std::atomic<quint64> m_droppedFrames;
+};
+
+/**
+ * @brief Per-camera analysis stage: motion, ROI, tripwire, AI detection and tracking
+ *
+ * Runs on the shared PipelineExecutor rather than a thread of its own. Every
+ * call, configuration changes included, is posted to the camera's strand, so
+ * the state below is only touched by one pool thread at a time and frames
+ * are analyzed in capture order.
+ */
+class FrameAnalyzer : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit CaptureWorker(int cameraIndex = 0);
-    ~CaptureWorker();
+    explicit FrameAnalyzer(QObject *parent = nullptr);
 
-    void setSource(int cameraIndex);
-    void setSourceUrl(const QString &url);
-    void processMotionDetection(const cv::Mat &frame);
-    void processRoiMotion(const cv::Mat &motionMask, int width, int height);
-    void processTripwire(const cv::Mat &motionMask, int width, int height);
-    void processAIDetection(const cv::Mat &frame);
+    // Whether any analysis is enabled; lets the capture thread skip posting frames
+    bool isActive() const;
 
-public slots:
-    void start();
-    void stop();
-    void captureFrame();
-    void setMotionEnabled(bool enabled) { m_motionEnabled = enabled; }
+    // image is the RGB copy of the same frame already handed to the GUI;
+    // events carry it and its capture time, so evidence matches the frame
+    // that triggered them
+    void analyzeFrame(const cv::Mat &frame, const QImage &image, qint64 capturedMs);
+
+    void setMotionEnabled(bool enabled) { m_motionEnabled.store(enabled, std::memory_order_relaxed); }
     void setMotionSensitivity(double sensitivity) { m_motionSensitivity = sensitivity; }
     void setRoiPolygon(const QVector<QPointF> &normalizedPoints);
     void clearRoi();
@@ -69,34 +101,33 @@ public slots:
     void setAiEnabled(bool enabled);
     void setAiConfidenceThreshold(double threshold);
     void setObjectDetector(ObjectDetector *detector);
+    
+    // Must be set before the first frame is posted
+    void setMetrics(std::shared_ptr<CameraMetrics> metrics) { m_metrics = std::move(metrics); }
 
 signals:
-    void frameCaptured(const QImage &frame);
-    void fpsUpdated(double fps);
-    void errorOccurred(const QString &error);
-    void motionDetected(double score, const cv::Mat &frame);
-    void roiMotionDetected(double score, const cv::Mat &frame);
-    void tripwireCrossed(int direction, const cv::Mat &frame);
+    void motionDetected(double score, const QImage &frame, qint64 frameTimeMs);
+    void roiMotionDetected(double score, const QImage &frame, qint64 frameTimeMs);
+    void tripwireCrossed(int direction, const QImage &frame, qint64 frameTimeMs);
     void aiDetectionsReady(const std::vector<Detection> &detections);
-    void trackCrossedTripwire(int trackId, const QString &label, const QString &direction, const cv::Mat &frame);
-    void loiteringDetected(int trackId, const QString &label, qint64 durationMs, const cv::Mat &frame);
+    void trackCrossedTripwire(int trackId, const QString &label, const QString &direction, const QImage &frame, qint64 frameTimeMs);
+    void loiteringDetected(int trackId, const QString &label, qint64 durationMs, const QImage &frame, qint64 frameTimeMs);
 
 private:
-    cv::VideoCapture m_capture;
-    int m_cameraIndex;
-    QString m_sourceUrl;
-    bool m_isUrlSource;
-    std::atomic<bool> m_running;
-    QTimer *m_timer;
-    
-    // FPS calculation
-    qint64 m_lastFrameTime;
-    int m_frameCount;
-    double m_currentFps;
+    void processMotionDetection(const cv::Mat &frame);
+    void processRoiMotion(const cv::Mat &motionMask, int width, int height);
+    void processTripwire(const cv::Mat &motionMask, int width, int height);
+    void processAIDetection(const cv::Mat &frame);
+
+    // Frame being analyzed; shared (not copied) into every event it raises
+    QImage m_eventFrame;
+    qint64 m_eventFrameMs;
     
+    std::shared_ptr<CameraMetrics> m_metrics;
+
     // Motion detection
     cv::Ptr<cv::BackgroundSubtractorMOG2> m_backgroundSubtractor;
-    bool m_motionEnabled;
+    std::atomic<bool> m_motionEnabled;
     double m_motionSensitivity;
     qint64 m_lastMotionTime;
     
@@ -114,7 +145,7 @@ private:
     
     // AI Detection
     ObjectDetector *m_detector;
-    std::atomic<bool> m_aiEnabled;  // Atomic for lock-free toggle
+    std::atomic<bool> m_aiEnabled;  // Atomic so the capture thread can read it
     int m_aiFrameCounter;
     static constexpr int AI_PROCESS_INTERVAL = 5; // Process every 5 frames
     
@@ -143,6 +174,71 @@ private:
     void checkLoitering(TrackState &track, qint64 currentTime);
 };
 
+/**
+ * @brief Worker thread class that handles OpenCV camera capture
+ *
+ * Only decoding stays on this per-camera thread (VideoCapture blocks on I/O).
+ * Captured frames go to the GUI through the mailbox and, when analysis is
+ * enabled, to the camera's FrameAnalyzer strand on the shared pool.
+ */
+class CaptureWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureWorker(int cameraIndex = 0);
+    ~CaptureWorker();
+
+    void setSource(int cameraIndex);
+    void setSourceUrl(const QString &url);
+    
+    // Must be called before the worker is moved to its thread
+    void setAnalysisStage(FrameAnalyzer *analyzer, std::shared_ptr<PipelineStrand> strand);
+    void setClipRecorder(EventClipRecorder *recorder) { m_clipRecorder = recorder; }
+    void setMetrics(std::shared_ptr<CameraMetrics> metrics) { m_metrics = std::move(metrics); }
+    
+    FrameMailbox *mailbox() { return &m_mailbox; }
+    quint64 droppedAnalysisFrames() const { return m_droppedAnalysisFrames.load(std::memory_order_relaxed); }
+
+public slots:
+    void start();
+    void stop();
+    void captureFrame();
+
+signals:
+    void frameAvailable();
+    void fpsUpdated(double fps);
+    void errorOccurred(const QString &error);
+
+private:
+    cv::VideoCapture m_capture;
+    int m_cameraIndex;
+    QString m_sourceUrl;
+    bool m_isUrlSource;
+    std::atomic<bool> m_running;
+    QTimer *m_timer;
+    FrameMailbox m_mailbox;
+    
+    // FPS calculation
+    qint64 m_lastFrameTime;
+    int m_frameCount;
+    double m_currentFps;
+    
+    // Analysis stage on the shared pool
+    FrameAnalyzer *m_analyzer;
+    std::shared_ptr<PipelineStrand> m_strand;
+    std::atomic<quint64> m_droppedAnalysisFrames;
+    
+    // Pre-event buffer, owned by the CameraStream
+    EventClipRecorder *m_clipRecorder;
+    
+    std::shared_ptr<CameraMetrics> m_metrics;
+    
+    // Frames are skipped for analysis while this many are already queued or
+    // running, so a slow camera sheds load instead of growing an unbounded backlog
+    static constexpr int MAX_ANALYSIS_BACKLOG = 2;
+};
+
 /**
  * @brief Main camera stream class exposed to QML
  */
@@ -153,8 +249,10 @@ class CameraStream : public QObject
     Q_PROPERTY(QString source READ source CONSTANT)
     Q_PROPERTY(QString sourceType READ sourceType CONSTANT)
     Q_PROPERTY(QImage frame READ frame NOTIFY frameChanged)
+    Q_PROPERTY(quint64 frameSequence READ frameSequence NOTIFY frameChanged)
     Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
     Q_PROPERTY(double fps READ fps NOTIFY fpsChanged)
+    Q_PROPERTY(quint64 droppedFrames READ droppedFrames NOTIFY droppedFramesChanged)
     Q_PROPERTY(QString status READ status NOTIFY statusChanged)
     Q_PROPERTY(QString cameraName READ cameraName WRITE setCameraName NOTIFY cameraNameChanged)
     Q_PROPERTY(bool motionEnabled READ motionEnabled WRITE setMotionEnabled NOTIFY motionEnabledChanged)
@@ -168,18 +266,25 @@ class CameraStream : public QObject
 Q_PROPERTY(bool autoSnapshotOnMotion READ autoSnapshotOnMotion WRITE setAutoSnapshotOnMotion NOTIFY autoSnapshotOnMotionChanged)
 Q_PROPERTY(bool autoSnapshotOnRoi READ autoSnapshotOnRoi WRITE setAutoSnapshotOnRoi NOTIFY autoSnapshotOnRoiChanged)
 Q_PROPERTY(bool autoSnapshotOnTripwire READ autoSnapshotOnTripwire WRITE setAutoSnapshotOnTripwire NOTIFY autoSnapshotOnTripwireChanged)
+    Q_PROPERTY(bool eventClipsEnabled READ eventClipsEnabled WRITE setEventClipsEnabled NOTIFY eventClipsEnabledChanged)
+    Q_PROPERTY(int uiRefreshRate READ uiRefreshRate WRITE setUiRefreshRate NOTIFY uiRefreshRateChanged)
 
 public:
-    explicit CameraStream(const QString &id, const QString &source, const QString &sourceType, const QString &name, QObject *parent = nullptr);
+    explicit CameraStream(const QString &id, const QString &source, const QString &sourceType, const QString &name,
+                          PipelineExecutor *executor, QObject *parent = nullptr);
     ~CameraStream();
 
     // Property getters
     QString id() const { return m_id; }
     QString source() const { return m_source; }
     QString sourceType() const { return m_sourceType; }
-    QImage frame() const { return m_currentFrame; }
+    QImage frame() const { QMutexLocker locker(&m_frameMutex); return m_currentFrame; }
+    // Frame and its sequence number read together; safe from any thread
+    QImage frame(quint64 *sequence) const { QMutexLocker locker(&m_frameMutex); *sequence = m_frameSequence; return m_currentFrame; }
+    quint64 frameSequence() const { return m_frameSequence; }
     bool isRunning() const { return m_running; }
     double fps() const { return m_fps; }
+    quint64 droppedFrames() const { return m_droppedFrames; }
     QString status() const { return m_status; }
     QString cameraName() const { return m_cameraName; }
     bool motionEnabled() const { return m_motionEnabled; }
@@ -200,6 +305,30 @@ void setAutoSnapshotOnRoi(bool enabled);
 bool autoSnapshotOnTripwire() const { return m_autoSnapshotOnTripwire; }
 void setAutoSnapshotOnTripwire(bool enabled);
 
+    // Event clips: a few seconds before and after an alert, from a compressed frame buffer
+    bool eventClipsEnabled() const { return m_clipRecorder->isEnabled(); }
+    void setEventClipsEnabled(bool enabled);
+    void setEventClipDirectory(const QString &dirPath);
+    
+    // Pipeline counters and timings; safe to read from any thread
+    const CameraMetrics &metrics() const { return *m_metrics; }
+    int analysisBacklog() const { return m_strand ? m_strand->backlog() : 0; }
+    quint64 droppedAnalysisFrames() const { return m_worker->droppedAnalysisFrames(); }
+    quint64 droppedDisplayFrames() const { return m_worker->mailbox()->droppedFrames(); }
+    quint64 droppedClipFrames() const { return m_clipRecorder->droppedFrames(); }
+
+    // Starts a clip around eventTimeMs (ms since the epoch, the capture time
+    // of the triggering frame) and returns the file it will be written to,
+    // or an empty string if event clips are disabled. The file
+    // only exists once eventClipSaved() reports it; eventClipFailed() is
+    // emitted instead if it could not be written, including for clips still
+    // pending when clips are disabled or the stream is destroyed.
+    QString recordEventClip(qint64 eventTimeMs);
+
+    // Maximum rate (Hz) at which worker-driven property changes are pushed to QML
+    int uiRefreshRate() const { return m_uiRefreshRate; }
+    void setUiRefreshRate(int rate);
+
     void setCameraName(const QString &name) { m_cameraName = name; emit cameraNameChanged(); }
     void setMotionEnabled(bool enabled);
     void setMotionSensitivity(double sensitivity);
@@ -226,6 +355,7 @@ signals:
     void frameChanged();
     void runningChanged();
     void fpsChanged();
+    void droppedFramesChanged();
     void statusChanged();
     void cameraNameChanged();
     void snapshotSaved(const QString &filePath);
@@ -233,13 +363,18 @@ signals:
     void motionEnabledChanged();
     void motionSensitivityChanged();
     void motionActiveChanged();
-    void motionDetected(double score);
-    void roiMotionDetected(double score);
-    void tripwireCrossed(int direction);
-    void trackCrossedTripwire(int trackId, const QString &label, const QString &direction);
-    void loiteringDetected(int trackId, const QString &label, qint64 durationMs);
+    // frame is the frame that triggered the event (may be null), captured
+    // at frameTimeMs since the epoch
+    void motionDetected(double score, const QImage &frame, qint64 frameTimeMs);
+    void roiMotionDetected(double score, const QImage &frame, qint64 frameTimeMs);
+    void tripwireCrossed(int direction, const QImage &frame, qint64 frameTimeMs);
+    void trackCrossedTripwire(int trackId, const QString &label, const QString &direction, const QImage &frame, qint64 frameTimeMs);
+    void loiteringDetected(int trackId, const QString &label, qint64 durationMs, const QImage &frame, qint64 frameTimeMs);
     void roiAlertActiveChanged();
     void tripwireAlertActiveChanged();
+    void eventClipsEnabledChanged();
+    void eventClipSaved(const QString &filePath);
+    void eventClipFailed(const QString &filePath);
     void aiEnabledChanged();
     void aiConfidenceThresholdChanged();
     void detectionsChanged();
@@ -247,29 +382,52 @@ signals:
 void autoSnapshotOnMotionChanged();
     void autoSnapshotOnRoiChanged();
     void autoSnapshotOnTripwireChanged();
+    void uiRefreshRateChanged();
 
 
 private slots:
-    void onFrameCaptured(const QImage &frame);
+    void onFrameAvailable();
     void onFpsUpdated(double fps);
     void onErrorOccurred(const QString &error);
-    void onMotionDetected(double score, const cv::Mat &frame);
-    void onRoiMotionDetected(double score, const cv::Mat &frame);
-    void onTripwireCrossed(int direction, const cv::Mat &frame);
-    void onTrackCrossedTripwire(int trackId, const QString &label, const QString &direction, const cv::Mat &frame);
-    void onLoiteringDetected(int trackId, const QString &label, qint64 durationMs, const cv::Mat &frame);
+    void onMotionDetected(double score, const QImage &frame, qint64 frameTimeMs);
+    void onRoiMotionDetected(double score, const QImage &frame, qint64 frameTimeMs);
+    void onTripwireCrossed(int direction, const QImage &frame, qint64 frameTimeMs);
+    void onTrackCrossedTripwire(int trackId, const QString &label, const QString &direction, const QImage &frame, qint64 frameTimeMs);
+    void onLoiteringDetected(int trackId, const QString &label, qint64 durationMs, const QImage &frame, qint64 frameTimeMs);
     void onAIDetectionsReady(const std::vector<Detection> &detections);
     void resetMotionActive();
     void resetRoiAlertActive();
     void resetTripwireAlertActive();
+    void flushNotifications();
+    void flushOverdueClips();
 
 private:
+    /**
+     * @brief Property notifications that are coalesced to the UI refresh rate
+     */
+    enum PendingNotification {
+        NotifyFrame               = 0x01,
+        NotifyFps                 = 0x02,
+        NotifyStatus              = 0x04,
+        NotifyDetections          = 0x08,
+        NotifyMotionActive        = 0x10,
+        NotifyRoiAlertActive      = 0x20,
+        NotifyTripwireAlertActive = 0x40,
+        NotifyDroppedFrames       = 0x80
+    };
+
+    void scheduleNotification(int flags);
+    void setStatus(const QString &status);
+    void postToAnalyzer(std::function<void(FrameAnalyzer*)> change);
+
     QString m_id;
     QString m_source;
     QString m_sourceType;
     QImage m_currentFrame;
+    quint64 m_frameSequence;
     bool m_running;
     double m_fps;
+    quint64 m_droppedFrames;
     QString m_status;
     QString m_cameraName;
     int m_cameraIndex;
@@ -310,6 +468,18 @@ private:
     
     QThread *m_workerThread;
     CaptureWorker *m_worker;
+    FrameAnalyzer *m_analyzer;
+    std::shared_ptr<PipelineStrand> m_strand;
+    std::unique_ptr<EventClipRecorder> m_clipRecorder;  // Compresses on its own strand
+    std::shared_ptr<CameraMetrics> m_metrics;           // Shared with the worker and the analyzer
+    QTimer *m_clipFlushTimer;                           // Finishes clips of a stalled camera
+    static constexpr int CLIP_FLUSH_INTERVAL_MS = 1000;
+    
+    // Notification batching
+    QTimer *m_notifyTimer;
+    int m_pendingNotifications;
+    int m_uiRefreshRate;
+    static constexpr int DEFAULT_UI_REFRESH_RATE = 30;  // Hz
     
     mutable QMutex m_frameMutex;
     mutable QMutex m_detectionMutex;
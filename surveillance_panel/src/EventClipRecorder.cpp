@@ -0,0 +1,256 @@
+#include "EventClipRecorder.h"
+#include "PipelineExecutor.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QDebug>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+#include <algorithm>
+#include <limits>
+
+EventClipRecorder::EventClipRecorder(std::shared_ptr<PipelineStrand> strand, const QString &cameraId)
+    : m_strand(std::move(strand))
+    , m_cameraId(cameraId)
+    , m_enabled(false)
+    , m_droppedFrames(0)
+    , m_lastQueuedMs(0)
+    , m_bufferedBytes(0)
+{
+}
+
+EventClipRecorder::~EventClipRecorder()
+{
+    shutdown();
+}
+
+void EventClipRecorder::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+
+    if (!enabled) {
+        QMutexLocker locker(&m_mutex);
+        startFinishedClips(std::numeric_limits<qint64>::max());
+        m_frames.clear();
+        m_bufferedBytes = 0;
+        m_pendingClips.clear();
+    }
+}
+
+void EventClipRecorder::setOutputDirectory(const QString &dirPath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_outputDirectory = dirPath;
+}
+
+void EventClipRecorder::addFrame(const cv::Mat &frame, qint64 timestampMs)
+{
+    if (!isEnabled() || !m_strand) {
+        return;
+    }
+
+    // Clips do not need the full capture rate
+    if (timestampMs - m_lastQueuedMs < 1000 / BUFFER_FPS) {
+        return;
+    }
+
+    if (m_strand->backlog() >= MAX_COMPRESS_BACKLOG) {
+        m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    m_lastQueuedMs = timestampMs;
+
+    // cv::Mat is reference counted; the strand shares the captured frame
+    m_strand->post([this, frame, timestampMs]() {
+        compressFrame(frame, timestampMs);
+    });
+}
+
+QString EventClipRecorder::requestClip(qint64 eventTimeMs)
+{
+    if (!isEnabled()) {
+        return QString();
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // Extend a clip that is still collecting frames rather than overlap it
+    for (PendingClip &clip : m_pendingClips) {
+        if (eventTimeMs <= clip.endMs) {
+            clip.endMs = std::min(std::max(clip.endMs, eventTimeMs + POST_ROLL_MS),
+                                  clip.startMs + MAX_CLIP_MS);
+            return clip.filePath;
+        }
+    }
+
+    if (m_outputDirectory.isEmpty()) {
+        return QString();
+    }
+
+    PendingClip clip;
+    clip.startMs = eventTimeMs - PRE_ROLL_MS;
+    clip.endMs = eventTimeMs + POST_ROLL_MS;
+    clip.filePath = QDir(m_outputDirectory).filePath(
+        QString("clip_%1_%2.avi")
+            .arg(m_cameraId)
+            .arg(QDateTime::fromMSecsSinceEpoch(eventTimeMs).toString("yyyyMMdd_HHmmss_zzz")));
+    m_pendingClips.append(clip);
+
+    return clip.filePath;
+}
+
+void EventClipRecorder::flushOverdueClips(qint64 nowMs)
+{
+    QMutexLocker locker(&m_mutex);
+    startFinishedClips(nowMs - STALL_GRACE_MS);
+}
+
+QStringList EventClipRecorder::discardPendingClips()
+{
+    QMutexLocker locker(&m_mutex);
+
+    QStringList filePaths;
+    for (const PendingClip &clip : std::as_const(m_pendingClips)) {
+        filePaths.append(clip.filePath);
+    }
+    m_pendingClips.clear();
+    return filePaths;
+}
+
+qint64 EventClipRecorder::bufferedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bufferedBytes;
+}
+
+void EventClipRecorder::shutdown()
+{
+    m_enabled.store(false, std::memory_order_relaxed);
+    if (m_strand) {
+        m_strand->shutdown();
+    }
+}
+
+void EventClipRecorder::compressFrame(const cv::Mat &frame, qint64 timestampMs)
+{
+    std::vector<uchar> encoded;
+    const std::vector<int> params = { cv::IMWRITE_JPEG_QUALITY, JPEG_QUALITY };
+    if (frame.empty() || !cv::imencode(".jpg", frame, encoded, params)) {
+        return;
+    }
+
+    BufferedFrame buffered;
+    buffered.timestampMs = timestampMs;
+    buffered.jpeg = QByteArray(reinterpret_cast<const char *>(encoded.data()),
+                               static_cast<int>(encoded.size()));
+
+    QMutexLocker locker(&m_mutex);
+    if (!isEnabled()) {
+        return;
+    }
+
+    m_bufferedBytes += buffered.jpeg.size();
+    m_frames.push_back(std::move(buffered));
+
+    startFinishedClips(timestampMs);
+    trimBuffer(timestampMs);
+}
+
+void EventClipRecorder::trimBuffer(qint64 newestMs)
+{
+    // Keep the pre-roll, and everything a pending clip still needs
+    qint64 keepFromMs = newestMs - PRE_ROLL_MS;
+    for (const PendingClip &clip : m_pendingClips) {
+        keepFromMs = std::min(keepFromMs, clip.startMs);
+    }
+
+    while (!m_frames.empty() && m_frames.front().timestampMs < keepFromMs) {
+        m_bufferedBytes -= m_frames.front().jpeg.size();
+        m_frames.pop_front();
+    }
+
+    // The memory cap wins over pre-roll: a long clip just starts later
+    while (m_frames.size() > 1 && m_bufferedBytes > MAX_BUFFER_BYTES) {
+        m_bufferedBytes -= m_frames.front().jpeg.size();
+        m_frames.pop_front();
+    }
+}
+
+void EventClipRecorder::startFinishedClips(qint64 newestMs)
+{
+    for (int i = m_pendingClips.count() - 1; i >= 0; --i) {
+        const PendingClip clip = m_pendingClips.at(i);
+        if (newestMs < clip.endMs) {
+            continue;
+        }
+        m_pendingClips.remove(i);
+
+        QVector<BufferedFrame> frames;
+        for (const BufferedFrame &frame : m_frames) {
+            if (frame.timestampMs >= clip.startMs && frame.timestampMs <= clip.endMs) {
+                frames.append(frame);
+            }
+        }
+
+        ClipCallback callback = m_clipCallback;
+        QThreadPool::globalInstance()->start([clip, frames, callback]() {
+            const bool success = writeClip(clip.filePath, frames);
+            if (callback) {
+                callback(clip.filePath, success);
+            }
+        });
+    }
+}
+
+bool EventClipRecorder::writeClip(const QString &filePath, const QVector<BufferedFrame> &frames)
+{
+    if (frames.isEmpty()) {
+        qWarning() << "No buffered frames for clip:" << filePath;
+        return false;
+    }
+
+    QDir dir = QFileInfo(filePath).dir();
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qWarning() << "Failed to create directory:" << dir.path();
+        return false;
+    }
+
+    // Play back at the rate the frames were buffered
+    double fps = BUFFER_FPS;
+    const qint64 spanMs = frames.last().timestampMs - frames.first().timestampMs;
+    if (frames.count() > 1 && spanMs > 0) {
+        fps = std::clamp((frames.count() - 1) * 1000.0 / spanMs, 1.0, double(BUFFER_FPS));
+    }
+
+    cv::VideoWriter writer;
+    for (const BufferedFrame &buffered : frames) {
+        const cv::Mat encoded(1, buffered.jpeg.size(), CV_8UC1,
+                              const_cast<char *>(buffered.jpeg.constData()));
+        cv::Mat image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+        if (image.empty()) {
+            continue;
+        }
+
+        // Sized from the first frame that decodes
+        if (!writer.isOpened() &&
+            !writer.open(filePath.toStdString(), cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                         fps, image.size())) {
+            qWarning() << "Failed to open clip for writing:" << filePath;
+            QFile::remove(filePath);
+            return false;
+        }
+        writer.write(image);
+    }
+
+    if (!writer.isOpened()) {
+        qWarning() << "No decodable frames for clip:" << filePath;
+        return false;
+    }
+    writer.release();
+
+    qDebug() << "Event clip saved:" << filePath << "-" << frames.count() << "frames";
+    return true;
+}
@@ -0,0 +1,115 @@
+#ifndef EVENTCLIPRECORDER_H
+#define EVENTCLIPRECORDER_H
+
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+class PipelineStrand;
+
+/**
+ * @brief Per-camera pre-event frame buffer that cuts short clips around alerts
+ *
+ * The capture thread only hands frames over; they are compressed to JPEG on
+ * the recorder's own strand and the last few seconds are kept, capped at
+ * MAX_BUFFER_BYTES. A clip covers PRE_ROLL_MS before the event and
+ * POST_ROLL_MS after it. Once the post-roll is buffered the frames are
+ * written with cv::VideoWriter on the global thread pool, so neither capture
+ * nor analysis waits on disk. An event inside a clip that is still being
+ * collected extends that clip instead of starting another one.
+ *
+ * Every requested clip is reported exactly once through the clip callback,
+ * saved or failed, unless it is discarded with discardPendingClips().
+ */
+class EventClipRecorder
+{
+public:
+    // Runs on a pool thread once a clip has been written or has failed
+    using ClipCallback = std::function<void(const QString &filePath, bool success)>;
+
+    EventClipRecorder(std::shared_ptr<PipelineStrand> strand, const QString &cameraId);
+    ~EventClipRecorder();
+
+    // Disabling writes the clips already requested with the frames buffered
+    // so far, then drops the buffer
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void setOutputDirectory(const QString &dirPath);
+
+    // Must be set before frames are added
+    void setClipCallback(ClipCallback callback) { m_clipCallback = std::move(callback); }
+
+    // Called from the capture thread. Never waits: frames are thinned to
+    // BUFFER_FPS and skipped while compression is behind.
+    void addFrame(const cv::Mat &frame, qint64 timestampMs);
+
+    // Schedules a clip around eventTimeMs. Returns the file the clip will be
+    // written to, or an empty string if recording is disabled.
+    QString requestClip(qint64 eventTimeMs);
+
+    // Writes clips whose post-roll should have arrived STALL_GRACE_MS ago,
+    // with whatever was buffered; for a camera that stopped delivering frames
+    void flushOverdueClips(qint64 nowMs);
+
+    // Forgets the clips not yet written, without reporting them, and
+    // returns their files
+    QStringList discardPendingClips();
+
+    qint64 bufferedBytes() const;
+    quint64 droppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+    // Stops accepting frames and waits for a compression still running
+    void shutdown();
+
+private:
+    struct BufferedFrame {
+        qint64 timestampMs;
+        QByteArray jpeg;    // Shared with clip writers, not copied
+    };
+
+    struct PendingClip {
+        qint64 startMs;
+        qint64 endMs;
+        QString filePath;
+    };
+
+    // Strand side
+    void compressFrame(const cv::Mat &frame, qint64 timestampMs);
+    void trimBuffer(qint64 newestMs);
+    void startFinishedClips(qint64 newestMs);
+
+    // Pool side
+    static bool writeClip(const QString &filePath, const QVector<BufferedFrame> &frames);
+
+    std::shared_ptr<PipelineStrand> m_strand;
+    QString m_cameraId;
+    ClipCallback m_clipCallback;
+    std::atomic<bool> m_enabled;
+    std::atomic<quint64> m_droppedFrames;
+    qint64 m_lastQueuedMs;  // Capture thread only
+
+    mutable QMutex m_mutex;
+    std::deque<BufferedFrame> m_frames;
+    qint64 m_bufferedBytes;
+    QVector<PendingClip> m_pendingClips;
+    QString m_outputDirectory;
+
+    static constexpr qint64 PRE_ROLL_MS = 5000;
+    static constexpr qint64 POST_ROLL_MS = 5000;
+    static constexpr qint64 MAX_CLIP_MS = 30000;        // Extensions stop here
+    static constexpr qint64 STALL_GRACE_MS = 3000;
+    static constexpr int BUFFER_FPS = 10;
+    static constexpr qint64 MAX_BUFFER_BYTES = 24 * 1024 * 1024;
+    static constexpr int JPEG_QUALITY = 70;
+    static constexpr int MAX_COMPRESS_BACKLOG = 2;
+};
+
+#endif // EVENTCLIPRECORDER_H
@@ -0,0 +1,168 @@
+#include "HttpRequestParser.h"
+#include <algorithm>
+
+bool HttpRequest::keepAlive() const
+{
+    const QString connection = header("connection").toLower();
+
+    // HTTP/1.1 keeps connections open unless told otherwise, 1.0 only on request
+    if (version == "HTTP/1.1") {
+        return !connection.contains("close");
+    }
+    return connection.contains("keep-alive");
+}
+
+HttpRequestParser::HttpRequestParser()
+{
+    reset();
+}
+
+void HttpRequestParser::reset()
+{
+    m_scanned = 0;
+    m_headLength = -1;
+    m_contentLength = 0;
+    m_request = HttpRequest();
+    m_errorStatus = 0;
+    m_errorMessage.clear();
+}
+
+HttpRequestParser::Result HttpRequestParser::parse(QByteArray &buffer, HttpRequest *request)
+{
+    if (m_headLength < 0) {
+        // Empty lines between pipelined requests are allowed
+        int skip = 0;
+        while (skip + 1 < buffer.size() && buffer.at(skip) == '\r' && buffer.at(skip + 1) == '\n') {
+            skip += 2;
+        }
+        if (skip > 0) {
+            buffer.remove(0, skip);
+            m_scanned = 0;
+        }
+
+        // Resume the search where the last one stopped; the terminator may straddle it
+        const int headEnd = buffer.indexOf("\r\n\r\n", std::max(0, m_scanned - 3));
+        if (headEnd < 0) {
+            m_scanned = buffer.size();
+            if (buffer.size() > MAX_HEADER_BYTES) {
+                return fail(431, "Request Header Fields Too Large");
+            }
+            return Result::Incomplete;
+        }
+
+        if (headEnd > MAX_HEADER_BYTES) {
+            return fail(431, "Request Header Fields Too Large");
+        }
+
+        if (!parseHead(buffer, headEnd)) {
+            return Result::Failed;
+        }
+        m_headLength = headEnd + 4;
+    }
+
+    if (buffer.size() < m_headLength + m_contentLength) {
+        return Result::Incomplete;
+    }
+
+    m_request.body = buffer.mid(m_headLength, static_cast<int>(m_contentLength));
+    buffer.remove(0, m_headLength + static_cast<int>(m_contentLength));
+
+    *request = std::move(m_request);
+    reset();
+    return Result::Complete;
+}
+
+bool HttpRequestParser::parseHead(const QByteArray &buffer, int headLength)
+{
+    const char *data = buffer.constData();
+    int lineStart = 0;
+    int lineNumber = 0;
+    bool haveContentLength = false;
+
+    while (lineStart < headLength) {
+        int lineEnd = buffer.indexOf("\r\n", lineStart);
+        if (lineEnd < 0 || lineEnd > headLength) {
+            lineEnd = headLength;
+        }
+        const QByteArray line = QByteArray::fromRawData(data + lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 2;
+
+        if (lineNumber++ == 0) {
+            // Request line: "GET /path HTTP/1.1"
+            const int firstSpace = line.indexOf(' ');
+            const int lastSpace = line.lastIndexOf(' ');
+            if (firstSpace <= 0 || lastSpace <= firstSpace + 1) {
+                fail(400, "Bad Request");
+                return false;
+            }
+
+            m_request.method = QString::fromLatin1(line.left(firstSpace));
+            m_request.target = QString::fromLatin1(line.mid(firstSpace + 1, lastSpace - firstSpace - 1));
+            m_request.version = line.mid(lastSpace + 1);
+
+            if (m_request.version != "HTTP/1.1" && m_request.version != "HTTP/1.0") {
+                fail(505, "HTTP Version Not Supported");
+                return false;
+            }
+            continue;
+        }
+
+        if (m_request.headers.size() >= MAX_HEADER_COUNT) {
+            fail(431, "Request Header Fields Too Large");
+            return false;
+        }
+
+        // No whitespace before the colon, and no obsolete line folding
+        const int colon = line.indexOf(':');
+        if (colon <= 0 || line.at(0) == ' ' || line.at(0) == '\t' ||
+            line.at(colon - 1) == ' ' || line.at(colon - 1) == '\t') {
+            fail(400, "Bad Request");
+            return false;
+        }
+
+        const QString name = QString::fromLatin1(line.left(colon)).toLower();
+        const QString value = QString::fromLatin1(line.mid(colon + 1).trimmed());
+
+        auto it = m_request.headers.find(name);
+        if (it == m_request.headers.end()) {
+            m_request.headers.insert(name, value);
+        } else {
+            it.value() += ", " + value;
+        }
+
+        if (name == "content-length") {
+            bool ok;
+            const qint64 length = value.toLongLong(&ok);
+            if (!ok || length < 0 || (haveContentLength && length != m_contentLength)) {
+                fail(400, "Bad Request");
+                return false;
+            }
+            if (length > MAX_BODY_BYTES) {
+                fail(413, "Payload Too Large");
+                return false;
+            }
+            m_contentLength = length;
+            haveContentLength = true;
+        }
+    }
+
+    if (lineNumber == 0) {
+        fail(400, "Bad Request");
+        return false;
+    }
+
+    // Nothing served here takes a streamed body
+    if (m_request.headers.contains("transfer-encoding")) {
+        fail(501, "Not Implemented");
+        return false;
+    }
+
+    return true;
+}
+
+HttpRequestParser::Result HttpRequestParser::fail(int status, const QString &message)
+{
+    m_errorStatus = status;
+    m_errorMessage = message;
+    return Result::Failed;
+}
@@ -0,0 +1,72 @@
+#ifndef HTTPREQUESTPARSER_H
+#define HTTPREQUESTPARSER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+/**
+ * @brief A parsed HTTP/1.x request
+ */
+struct HttpRequest {
+    QString method;
+    QString target;                     // Path and query string as sent
+    QByteArray version;                 // "HTTP/1.0" or "HTTP/1.1"
+    QHash<QString, QString> headers;    // Names lowercased; repeated headers joined with ", "
+    QByteArray body;
+
+    QString header(const QString &name) const { return headers.value(name.toLower()); }
+
+    // Whether the client wants the connection kept open after the response
+    bool keepAlive() const;
+};
+
+/**
+ * @brief Incremental HTTP/1.x request parser working on raw bytes
+ *
+ * Fed the connection's receive buffer each time data arrives. Bytes already
+ * searched for the end of the head are not searched again, so a request that
+ * trickles in byte by byte costs linear time. A complete request, including
+ * a Content-Length body, is removed from the front of the buffer; whatever
+ * follows it is the start of the next pipelined request.
+ *
+ * Heads larger than MAX_HEADER_BYTES or with more than MAX_HEADER_COUNT
+ * fields are rejected, as are bodies over MAX_BODY_BYTES and chunked
+ * bodies. After a failure the connection should be closed.
+ */
+class HttpRequestParser
+{
+public:
+    enum class Result {
+        Incomplete,     // Wait for more data
+        Complete,       // *request is filled in
+        Failed          // See errorStatus()/errorMessage()
+    };
+
+    HttpRequestParser();
+
+    Result parse(QByteArray &buffer, HttpRequest *request);
+
+    int errorStatus() const { return m_errorStatus; }
+    QString errorMessage() const { return m_errorMessage; }
+
+    void reset();
+
+private:
+    bool parseHead(const QByteArray &buffer, int headLength);
+    Result fail(int status, const QString &message);
+
+    int m_scanned;              // Bytes already searched for the end of the head
+    int m_headLength;           // Including the blank line, -1 until found
+    qint64 m_contentLength;
+    HttpRequest m_request;      // Head of the request whose body is awaited
+
+    int m_errorStatus;
+    QString m_errorMessage;
+
+    static constexpr int MAX_HEADER_BYTES = 16 * 1024;
+    static constexpr int MAX_HEADER_COUNT = 100;
+    static constexpr qint64 MAX_BODY_BYTES = 1024 * 1024;
+};
+
+#endif // HTTPREQUESTPARSER_H
@@ -4,16 +4,60 @@
 #include <QObject>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QHostAddress>
 #include <QString>
 #include <QByteArray>
-#include <QMap>
+#include <QHash>
+#include <QCache>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+#include <QThreadPool>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <atomic>
+#include <deque>
 #include <functional>
+#include "HttpRequestParser.h"
+#include "PipelineMetrics.h"
 
 class AlertLogModel;
+struct Alert;
 class CameraManager;
+class CameraStream;
+class JpegFrameCache;
+class MosaicComposer;
+struct EncodedFrame;
+class QUrlQuery;
+class QJsonObject;
 
 /**
  * @brief Lightweight HTTP server for exposing alerts and camera snapshots via REST API
+ *
+ * Meant to be moved to a thread of its own, which then does all socket I/O;
+ * start() and stop() may be called from any thread. Handlers that query the
+ * alert history or serialize JSON run on a small worker pool, and JPEG
+ * encoding on the frame cache's pool. Alerts and cameras are only read
+ * through their thread-safe accessors, never through the GUI-side models.
+ *
+ * Connections are HTTP/1.1 persistent: requests are parsed incrementally
+ * from each socket's buffer and answered strictly in order, one at a time,
+ * so pipelined requests queue up in the buffer while a response is being
+ * produced. Idle connections and requests that never complete are closed
+ * after a timeout.
+ *
+ * /alerts/stream pushes every new alert as a Server-Sent Event whose ID is
+ * the alert's sequence number. A client reconnecting with Last-Event-ID gets
+ * what it missed first: from a small buffer of recent events when it was
+ * gone briefly, otherwise from the alert history in batches.
+ *
+ * Under load the server sheds work rather than memory: connections beyond
+ * a global and a per-address cap get 503, clients sending requests faster
+ * than their per-address token bucket allows get 429, and a socket stops
+ * being read once its unparsed data hits a cap. Nothing more is produced
+ * for a socket that is not reading what it has been sent: no further
+ * pipelined responses, no stream frames, and no mosaic or JPEG encodes
+ * while every viewer is behind.
  */
 class HttpServer : public QObject
 {
@@ -26,13 +70,17 @@ public:
     // Set data providers
     void setAlertLogModel(AlertLogModel *model);
     void setCameraManager(CameraManager *manager);
+    
+    // Per client address: sustained requests per second and the burst allowed
+    // on top; call before the server moves to its thread
+    void setRateLimit(double requestsPerSecond, double burst);
 
     // Start/stop server
     bool start(quint16 port = 8080);
     void stop();
     
-    bool isRunning() const { return m_running; }
-    quint16 port() const { return m_port; }
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+    quint16 port() const { return m_port.load(std::memory_order_acquire); }
 
 signals:
     void serverStarted(quint16 port);
@@ -43,41 +91,210 @@ private slots:
     void onNewConnection();
     void onReadyRead();
     void onDisconnected();
+    void onBytesWritten();
+    void closeIdleConnections();
+    void onAlertAdded(const Alert &alert);
+    void sendEventHeartbeats();
 
 private:
     // HTTP request handling
-    void handleRequest(QTcpSocket *socket, const QString &method, 
-                      const QString &path, const QMap<QString, QString> &headers);
+    void processRequests(QTcpSocket *socket);
+    void rejectConnection(QTcpSocket *socket, const char *reason);
+    
+    // Takes a token from the address's bucket; false when it is empty, with
+    // the wait until the next token in *retryAfterSeconds
+    bool admitRequest(const QHostAddress &address, int *retryAfterSeconds);
+    void handleRequest(QTcpSocket *socket, const HttpRequest &request);
+    
+    // Ends the current response: closes the connection or moves on to the
+    // next request already buffered
+    void finishResponse(QTcpSocket *socket);
     
     // Route handlers
     void handlePing(QTcpSocket *socket);
-    void handleGetAlerts(QTcpSocket *socket);
-    void handleGetAlertSnapshot(QTcpSocket *socket, const QString &alertId);
+    void handleGetAlerts(QTcpSocket *socket, const HttpRequest &request, const QUrlQuery &query);
+    void handleGetAlertSnapshot(QTcpSocket *socket, const QString &alertId, const QUrlQuery &query);
+    void handleGetAlertStream(QTcpSocket *socket, const HttpRequest &request, const QUrlQuery &query);
     void handleGetCameras(QTcpSocket *socket);
-    void handleGetCameraSnapshot(QTcpSocket *socket, const QString &cameraId);
+    void handleGetCameraSnapshot(QTcpSocket *socket, const QString &cameraId, const QUrlQuery &query);
+    void handleGetCameraStream(QTcpSocket *socket, const QString &cameraId, const QUrlQuery &query);
+    void handleGetMosaic(QTcpSocket *socket, const QUrlQuery &query);
+    void handleGetMetrics(QTcpSocket *socket);
+    
+    // MJPEG streaming
+    void beginMultipartStream(QTcpSocket *socket);
+    CameraStream *findCamera(const QString &cameraId) const;
+    void onStreamedFrameChanged(CameraStream *stream);
+    void sendStreamFrame(const EncodedFrame &frame);
+    void removeStreamClient(QTcpSocket *socket);
+    bool hasReadyStreamClient(const QString &cameraId) const;
+    void catchUpStreamClient(QTcpSocket *socket);
+    
+    // Alert event stream
+    void replayAlertsFromStore(QTcpSocket *socket, qint64 afterSeq);
+    void sendRecentAlertEvents(QTcpSocket *socket);
+    static QJsonObject alertToJson(const Alert &alert);
+    static QByteArray alertEvent(const Alert &alert);
+    
+    // Validator for /alerts; changes whenever any alert does
+    QByteArray alertsETag() const;
+    static bool etagMatches(const QString &ifNoneMatch, const QByteArray &etag);
+    
+    /**
+     * @brief A complete response, built on a worker thread
+     */
+    struct Response {
+        int statusCode = 200;
+        QString statusText = "OK";
+        QString contentType;
+        QByteArray body;
+        QVector<QPair<QByteArray, QByteArray>> headers;    // Extra header fields
+    };
+    
+    // Runs work on the worker pool and sends its response from this thread,
+    // unless the client has gone away in the meantime
+    void respondFromWorker(QTcpSocket *socket, std::function<Response()> work);
+    static Response jsonResponse(int statusCode, const QByteArray &json);
+    static Response errorResponse(int statusCode, const QString &message);
+    static Response notFoundResponse(const QString &message);
     
     // HTTP response helpers
     void sendResponse(QTcpSocket *socket, int statusCode, const QString &statusText,
                      const QString &contentType, const QByteArray &body);
+    void sendResponse(QTcpSocket *socket, const Response &response);
     void sendJsonResponse(QTcpSocket *socket, int statusCode, const QByteArray &json);
     void sendImageResponse(QTcpSocket *socket, const QByteArray &imageData, 
                           const QString &mimeType);
     void sendNotFound(QTcpSocket *socket, const QString &message = "Not Found");
     void sendError(QTcpSocket *socket, int statusCode, const QString &message);
-    
-    // Request parsing
-    bool parseHttpRequest(const QByteArray &data, QString &method, 
-                         QString &path, QMap<QString, QString> &headers);
 
     QTcpServer *m_tcpServer;
     AlertLogModel *m_alertLogModel;
     CameraManager *m_cameraManager;
     
-    bool m_running;
-    quint16 m_port;
+    std::atomic<bool> m_running;
+    std::atomic<quint16> m_port;
+    
+    // Query and serialization work, off the I/O thread
+    QThreadPool m_workerPool;
+    static constexpr int WORKER_THREADS = 2;
+    
+    /**
+     * @brief Per-socket request state
+     */
+    struct ClientConnection {
+        QHostAddress peer;                  // Kept for the per-address count after disconnect
+        QByteArray buffer;                  // Received, not yet parsed
+        HttpRequestParser parser;
+        bool responding = false;            // A response is being produced
+        bool closeAfterResponse = false;
+        int requestsServed = 0;
+        qint64 idleSinceMs = 0;             // Last response finished (or connected)
+        qint64 requestStartMs = 0;          // First byte of the buffered request
+        qint64 dispatchedAtNs = 0;          // Request handed to its handler
+    };
+    
+    QHash<QTcpSocket*, ClientConnection> m_connections;
+    QElapsedTimer m_clock;
+    QTimer *m_idleTimer;
+    
+    static constexpr int KEEP_ALIVE_TIMEOUT_MS = 15000;     // Between requests
+    static constexpr int REQUEST_TIMEOUT_MS = 10000;        // To receive a whole request
+    static constexpr int MAX_REQUESTS_PER_CONNECTION = 1000;
+    static constexpr int IDLE_CHECK_INTERVAL_MS = 1000;
+    
+    /**
+     * @brief Token bucket limiting the request rate of one client address
+     */
+    struct RateBucket {
+        double tokens;
+        qint64 refilledMs;
+    };
+    
+    QHash<QHostAddress, int> m_connectionsPerAddress;
+    QHash<QHostAddress, RateBucket> m_rateBuckets;
+    double m_requestsPerSecond;
+    double m_requestBurst;
+    QHash<QString, quint64> m_rejectedConnections;     // By reason, for /metrics
+    
+    static constexpr int MAX_CONNECTIONS = 256;
+    static constexpr int MAX_CONNECTIONS_PER_ADDRESS = 32;
+    // Room for a few dashboards behind one NAT, each polling 8 cameras at 5 Hz
+    static constexpr double DEFAULT_REQUESTS_PER_SECOND = 200.0;
+    static constexpr double DEFAULT_REQUEST_BURST = 400.0;
+    static constexpr qint64 SOCKET_READ_BUFFER_BYTES = 64 * 1024;  // Beyond this, TCP pushes back
+    static constexpr int MAX_BUFFERED_BYTES = 2 * 1024 * 1024;     // Above the largest request the parser accepts
+    static constexpr qint64 MAX_WRITE_BACKLOG_BYTES = 4 * 1024 * 1024;  // Unsent responses before requests wait
+    
+    /**
+     * @brief A socket receiving a camera's MJPEG stream
+     */
+    struct StreamClient {
+        QString cameraId;       // Or the key of a mosaic
+        int quality;
+        quint64 lastSequence;   // Last frame sent, so a frame is never sent twice
+        bool waiting;           // Missed a frame while its socket was full
+    };
+    
+    // Streams and snapshots share one encode per camera frame and quality
+    JpegFrameCache *m_frameCache;
+    QHash<QTcpSocket*, StreamClient> m_streamClients;
+    QHash<QString, QMetaObject::Connection> m_streamFeeds;  // frameChanged of each streamed camera
+    
+    /**
+     * @brief An alert formatted as a Server-Sent Event
+     */
+    struct AlertEvent {
+        qint64 seq;
+        QByteArray data;
+    };
+    
+    /**
+     * @brief A socket subscribed to /alerts/stream
+     */
+    struct EventClient {
+        qint64 lastSeq;         // Last event sent, or the resume point
+        bool replaying;         // Catching up from the history; live events wait
+    };
+    
+    QHash<QTcpSocket*, EventClient> m_eventClients;
+    std::deque<AlertEvent> m_recentAlertEvents;     // Oldest first
+    qint64 m_lastAlertSeq;
+    QTimer *m_heartbeatTimer;
+    
+    static constexpr int MAX_RECENT_ALERT_EVENTS = 256;
+    static constexpr int ALERT_REPLAY_BATCH = 500;
+    static constexpr qint64 MAX_EVENT_BACKLOG_BYTES = 1024 * 1024;  // Unsent data before a client is dropped
+    static constexpr int EVENT_HEARTBEAT_INTERVAL_MS = 15000;
+    static constexpr int EVENT_RETRY_MS = 3000;
+    
+    // Mosaics by key; a stream client's cameraId holds the key of its mosaic
+    QHash<QString, MosaicComposer*> m_mosaics;
+    
+    static constexpr int DEFAULT_STREAM_QUALITY = 80;
+    static constexpr int DEFAULT_MOSAIC_WIDTH = 1280;
+    static constexpr int DEFAULT_MOSAIC_HEIGHT = 720;
+    static constexpr int MAX_MOSAIC_WIDTH = 3840;
+    static constexpr int MAX_MOSAIC_HEIGHT = 2160;
+    static constexpr int DEFAULT_MOSAIC_FPS = 5;
+    static constexpr int MAX_MOSAIC_FPS = 15;
+    static constexpr int MAX_MOSAIC_CAMERAS = 16;
+    static constexpr int DEFAULT_SNAPSHOT_QUALITY = 85;
+    
+    // Alert snapshots as served, keyed by "<id>/full" or "<id>/thumb"; filled by workers
+    QMutex m_snapshotCacheMutex;
+    QCache<QString, QByteArray> m_snapshotCache;     // Cost in KB
+    static constexpr int SNAPSHOT_CACHE_KB = 16 * 1024;
+    
+    // Served by /metrics; only touched on the server's thread
+    LatencyHistogram m_requestLatency;
+    QHash<int, quint64> m_responsesByStatus;
+    QHash<QString, quint64> m_alertsByType;
+    
+    qint64 m_etagEpoch;     // Server start time; revisions restart from zero with the process
     
-    // Track pending data for each socket
-    QMap<QTcpSocket*, QByteArray> m_pendingData;
+    static constexpr int DEFAULT_ALERTS_PER_REQUEST = 500;
+    static constexpr int MAX_ALERTS_PER_REQUEST = 5000;
 };
 
 #endif // HTTPSERVER_H
\ No newline at end of file
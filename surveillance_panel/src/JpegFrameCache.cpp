@@ -0,0 +1,90 @@
+#include "JpegFrameCache.h"
+#include "CameraStream.h"
+#include <QBuffer>
+#include <QImage>
+#include <QDebug>
+
+JpegFrameCache::JpegFrameCache(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(ENCODER_THREADS);
+}
+
+JpegFrameCache::~JpegFrameCache()
+{
+    // Encodes post their result back to this object; let them finish first
+    m_pool.waitForDone();
+}
+
+void JpegFrameCache::requestFrame(CameraStream *stream, int quality, Callback callback)
+{
+    quint64 sequence = 0;
+    const QImage image = stream->frame(&sequence);
+
+    const Key key(stream->id(), quality);
+    Entry &entry = m_entries[key];
+
+    // Served from the cache; copied first, the callback may request again
+    if (!entry.frame.jpeg.isEmpty() && entry.frame.sequence == sequence) {
+        const EncodedFrame frame = entry.frame;
+        callback(frame);
+        return;
+    }
+
+    if (image.isNull()) {
+        EncodedFrame frame;
+        frame.cameraId = key.first;
+        frame.quality = quality;
+        callback(frame);
+        return;
+    }
+
+    // Joins an encode in progress, even one of a slightly older frame
+    entry.waiters.append(std::move(callback));
+    if (!entry.encoding) {
+        entry.encoding = true;
+        startEncode(key, image, sequence);
+    }
+}
+
+void JpegFrameCache::startEncode(const Key &key, const QImage &image, quint64 sequence)
+{
+    m_pool.start([this, key, image, sequence]() {
+        EncodedFrame frame;
+        frame.cameraId = key.first;
+        frame.quality = key.second;
+        frame.sequence = sequence;
+
+        QBuffer buffer(&frame.jpeg);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, "JPEG", key.second)) {
+            qWarning() << "Failed to encode frame of camera" << key.first;
+            frame.jpeg.clear();
+        }
+
+        QMetaObject::invokeMethod(this, [this, frame]() {
+            finishEncode(frame);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void JpegFrameCache::finishEncode(const EncodedFrame &frame)
+{
+    auto it = m_entries.find(Key(frame.cameraId, frame.quality));
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    it->encoding = false;
+    if (!frame.jpeg.isEmpty()) {
+        it->frame = frame;
+    }
+
+    // Taken out before calling; callbacks may request the next frame
+    const QVector<Callback> waiters = std::move(it->waiters);
+    it->waiters.clear();
+
+    for (const Callback &callback : waiters) {
+        callback(frame);
+    }
+}
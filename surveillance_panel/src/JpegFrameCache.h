@@ -0,0 +1,67 @@
+#ifndef JPEGFRAMECACHE_H
+#define JPEGFRAMECACHE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+
+class CameraStream;
+
+/**
+ * @brief A camera frame encoded to JPEG, shared between every reader
+ */
+struct EncodedFrame {
+    QString cameraId;
+    quint64 sequence = 0;   // CameraStream frame sequence the JPEG was made from
+    int quality = 0;
+    QByteArray jpeg;        // Empty if there was no frame or encoding failed
+};
+
+/**
+ * @brief Encodes each camera frame to JPEG at most once per quality level
+ *
+ * Keeps the latest encoded frame per camera and quality. Requests for a frame
+ * that is already encoded are answered from the cache; otherwise the frame is
+ * encoded on the cache's own thread pool and every request that arrived in
+ * the meantime receives the same buffer. Only one encode per camera and
+ * quality runs at a time, so a burst of requests never queues encodes.
+ *
+ * Callbacks run on the thread the cache lives on.
+ */
+class JpegFrameCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Callback = std::function<void(const EncodedFrame &frame)>;
+
+    explicit JpegFrameCache(QObject *parent = nullptr);
+    ~JpegFrameCache();
+
+    // Delivers the stream's current frame at the given quality
+    void requestFrame(CameraStream *stream, int quality, Callback callback);
+
+private:
+    struct Entry {
+        EncodedFrame frame;
+        bool encoding = false;
+        QVector<Callback> waiters;
+    };
+
+    using Key = QPair<QString, int>;    // Camera ID, quality
+
+    void startEncode(const Key &key, const QImage &image, quint64 sequence);
+    void finishEncode(const EncodedFrame &frame);
+
+    QThreadPool m_pool;
+    QHash<Key, Entry> m_entries;
+
+    static constexpr int ENCODER_THREADS = 2;
+};
+
+#endif // JPEGFRAMECACHE_H
@@ -0,0 +1,151 @@
+#include "MosaicComposer.h"
+#include "CameraStream.h"
+#include <QBuffer>
+#include <QDebug>
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+
+MosaicComposer::MosaicComposer(const QString &key, const QVector<CameraStream*> &cameras,
+                               const QSize &size, int fps, int quality, QObject *parent)
+    : QObject(parent)
+    , m_key(key)
+    , m_cameras(cameras)
+    , m_size(size)
+    , m_quality(quality)
+    , m_timer(new QTimer(this))
+    , m_busy(false)
+    , m_lastSequences(cameras.count(), 0)
+{
+    m_lastFrame.cameraId = key;
+    m_lastFrame.quality = quality;
+
+    // Ticks never overlap, so one thread is all a mosaic needs
+    m_pool.setMaxThreadCount(1);
+
+    m_timer->setInterval(1000 / qMax(1, fps));
+    connect(m_timer, &QTimer::timeout, this, &MosaicComposer::tick);
+}
+
+MosaicComposer::~MosaicComposer()
+{
+    // The running tick posts back to this object
+    m_timer->stop();
+    m_pool.waitForDone();
+}
+
+void MosaicComposer::start()
+{
+    m_timer->start();
+    tick();
+}
+
+void MosaicComposer::tick()
+{
+    if (m_busy) {
+        return;
+    }
+
+    // Every viewer is still sending an earlier composite
+    if (m_viewerReady && !m_viewerReady()) {
+        return;
+    }
+
+    QVector<QImage> frames;
+    QVector<quint64> sequences;
+    frames.reserve(m_cameras.count());
+    sequences.reserve(m_cameras.count());
+
+    for (CameraStream *camera : std::as_const(m_cameras)) {
+        quint64 sequence = 0;
+        frames.append(camera->frame(&sequence));
+        sequences.append(sequence);
+    }
+
+    // Nothing new to show
+    if (sequences == m_lastSequences && !m_lastFrame.jpeg.isEmpty()) {
+        return;
+    }
+
+    m_busy = true;
+    m_pool.start([this, frames, sequences]() {
+        const QByteArray jpeg = compose(frames);
+
+        QMetaObject::invokeMethod(this, [this, jpeg, sequences]() {
+            finishFrame(jpeg, sequences);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MosaicComposer::finishFrame(const QByteArray &jpeg, const QVector<quint64> &sequences)
+{
+    m_busy = false;
+
+    if (jpeg.isEmpty()) {
+        qWarning() << "Failed to encode mosaic" << m_key;
+        return;
+    }
+
+    m_lastSequences = sequences;
+    m_lastFrame.sequence++;
+    m_lastFrame.jpeg = jpeg;
+
+    emit frameReady(m_lastFrame);
+}
+
+QByteArray MosaicComposer::compose(const QVector<QImage> &frames)
+{
+    if (m_canvas.size() != m_size) {
+        m_canvas = QImage(m_size, QImage::Format_RGB888);
+    }
+    m_canvas.fill(Qt::black);
+
+    // As square a grid as the camera count allows
+    const int count = qMax(1, int(frames.count()));
+    const int columns = static_cast<int>(std::ceil(std::sqrt(double(count))));
+    const int rows = (count + columns - 1) / columns;
+
+    // The canvas seen as a cv::Mat, so cells are written in place
+    cv::Mat canvas(m_canvas.height(), m_canvas.width(), CV_8UC3,
+                   m_canvas.bits(), static_cast<size_t>(m_canvas.bytesPerLine()));
+
+    for (int i = 0; i < frames.count(); ++i) {
+        QImage frame = frames.at(i);
+        if (frame.isNull()) {
+            continue;
+        }
+        // Capture delivers RGB888; anything else costs one conversion
+        if (frame.format() != QImage::Format_RGB888) {
+            frame = frame.convertToFormat(QImage::Format_RGB888);
+        }
+
+        const int column = i % columns;
+        const int row = i / columns;
+        const QRect cell(column * m_size.width() / columns, row * m_size.height() / rows,
+                         (column + 1) * m_size.width() / columns - column * m_size.width() / columns,
+                         (row + 1) * m_size.height() / rows - row * m_size.height() / rows);
+
+        // Letterboxed inside the cell
+        const QSize fitted = frame.size().scaled(cell.size(), Qt::KeepAspectRatio);
+        if (fitted.isEmpty()) {
+            continue;
+        }
+        const cv::Rect target(cell.x() + (cell.width() - fitted.width()) / 2,
+                              cell.y() + (cell.height() - fitted.height()) / 2,
+                              fitted.width(), fitted.height());
+
+        // Shares the frame's pixels; resize writes straight into the canvas
+        const cv::Mat source(frame.height(), frame.width(), CV_8UC3,
+                             const_cast<uchar *>(frame.constBits()),
+                             static_cast<size_t>(frame.bytesPerLine()));
+        cv::Mat destination = canvas(target);
+        cv::resize(source, destination, destination.size(), 0, 0, cv::INTER_AREA);
+    }
+
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    if (!m_canvas.save(&buffer, "JPEG", m_quality)) {
+        return QByteArray();
+    }
+    return jpeg;
+}
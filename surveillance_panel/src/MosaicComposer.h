@@ -0,0 +1,68 @@
+#ifndef MOSAICCOMPOSER_H
+#define MOSAICCOMPOSER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <functional>
+#include "JpegFrameCache.h"
+
+class CameraStream;
+
+/**
+ * @brief Composes the latest frames of several cameras into one grid image
+ *
+ * Runs at a fixed rate while it has viewers. Each tick composes and encodes
+ * one JPEG on the composer's own thread, and every viewer receives that same
+ * buffer. Sources are scaled straight into their cell of a canvas that is
+ * reused from tick to tick, keeping their aspect ratio. A tick is skipped
+ * while the previous one is still running, when no camera has a new frame,
+ * or when no viewer is ready to take one.
+ *
+ * The cameras must outlive the composer.
+ */
+class MosaicComposer : public QObject
+{
+    Q_OBJECT
+
+public:
+    MosaicComposer(const QString &key, const QVector<CameraStream*> &cameras,
+                   const QSize &size, int fps, int quality, QObject *parent = nullptr);
+    ~MosaicComposer();
+
+    void start();
+
+    // Asked before each tick; while it returns false nothing is composed
+    void setViewerReadyCheck(std::function<bool()> check) { m_viewerReady = std::move(check); }
+
+    // Latest composite; cameraId carries the mosaic key, empty JPEG before the first
+    const EncodedFrame &lastFrame() const { return m_lastFrame; }
+
+signals:
+    void frameReady(const EncodedFrame &frame);
+
+private:
+    void tick();
+    void finishFrame(const QByteArray &jpeg, const QVector<quint64> &sequences);
+
+    // Pool side
+    QByteArray compose(const QVector<QImage> &frames);
+
+    QString m_key;
+    QVector<CameraStream*> m_cameras;
+    QSize m_size;
+    int m_quality;
+    QTimer *m_timer;
+    QThreadPool m_pool;
+    bool m_busy;
+    QVector<quint64> m_lastSequences;
+    std::function<bool()> m_viewerReady;
+    EncodedFrame m_lastFrame;
+    QImage m_canvas;    // Pool side; one tick runs at a time
+};
+
+#endif // MOSAICCOMPOSER_H
@@ -40,7 +40,7 @@ ObjectDetector::ObjectDetector(const std::string &modelPath,
         if (!m_net.empty() && !m_classNames.empty()) {
             m_loaded = true;
             std::cout << "✓ YOLOv8 ObjectDetector initialized successfully!" << std::endl;
-            std::cout << "  Default confidence threshold: " << m_confThreshold << std::endl;
+            std::cout << "  Default confidence threshold: " << m_confThreshold.load() << std::endl;
         } else {
             std::cerr << "✗ Failed to load model or class names" << std::endl;
         }
@@ -56,7 +56,7 @@ bool ObjectDetector::isLoaded() const {
 
 void ObjectDetector::setConfidenceThreshold(float conf) {
     m_confThreshold = conf;
-    std::cout << "Confidence threshold updated to: " << m_confThreshold << std::endl;
+    std::cout << "Confidence threshold updated to: " << conf << std::endl;
 }
 
 float ObjectDetector::confidenceThreshold() const {
@@ -98,12 +98,20 @@ std::vector<Detection> ObjectDetector::infer(const cv::Mat &frameBgr) {
                                cv::Size(INPUT_WIDTH, INPUT_HEIGHT), 
                                cv::Scalar(), true, false);
         
-        // Set input
-        m_net.setInput(blob);
-        
-        // Forward pass
+        // The network is shared by every camera and cv::dnn::Net is not
+        // reentrant, so only the forward pass is serialized
         std::vector<cv::Mat> outputs;
-        m_net.forward(outputs, m_net.getUnconnectedOutLayersNames());
+        m_queuedInferences.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_netMutex);
+            m_queuedInferences.fetch_sub(1, std::memory_order_relaxed);
+            
+            // Set input
+            m_net.setInput(blob);
+            
+            // Forward pass
+            m_net.forward(outputs, m_net.getUnconnectedOutLayersNames());
+        }
         
         // Process output
         cv::Mat output = outputs[0];
@@ -121,7 +129,7 @@ std::vector<Detection> ObjectDetector::infer(const cv::Mat &frameBgr) {
         std::vector<cv::Rect> boxes;
         
         // Use a reasonable threshold - for hackathon demo, 0.4 works well
-        float threshold = std::max(0.4f, m_confThreshold);
+        float threshold = std::max(0.4f, m_confThreshold.load());
         
         // Process each detection
         float* data = (float*)output.data;
@@ -5,6 +5,8 @@
 #include <opencv2/dnn.hpp>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <mutex>
 
 struct Detection {
     int classId;
@@ -27,11 +29,16 @@ public:
     std::vector<Detection> infer(const cv::Mat &frameBgr); // BGR frame
 
     const std::vector<std::string> &classNames() const;
+    
+    // Callers waiting for the shared network, across all cameras
+    int queuedInferences() const { return m_queuedInferences.load(std::memory_order_relaxed); }
 
 private:
     cv::dnn::Net m_net;
+    std::mutex m_netMutex;  // infer() is called from several pipeline threads
+    std::atomic<int> m_queuedInferences{0};
     std::vector<std::string> m_classNames;
-    float m_confThreshold;
+    std::atomic<float> m_confThreshold;
     float m_nmsThreshold;
     bool m_loaded = false;
 
@@ -0,0 +1,226 @@
+#include "PipelineExecutor.h"
+#include <QDebug>
+#include <exception>
+
+namespace {
+// Identifies the pool (and slot) of the current thread so work scheduled from
+// inside a task lands on the local queue instead of a random one
+thread_local PipelineExecutor *t_currentExecutor = nullptr;
+thread_local int t_workerIndex = -1;
+}
+
+// ============================================================================
+// PipelineStrand Implementation
+// ============================================================================
+
+PipelineStrand::PipelineStrand(PipelineExecutor *executor)
+    : m_executor(executor)
+    , m_scheduled(false)
+    , m_running(false)
+    , m_closed(false)
+    , m_backlog(0)
+{
+}
+
+void PipelineStrand::post(Task task)
+{
+    bool needsSchedule = false;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_closed) {
+            return;
+        }
+
+        m_tasks.push_back(std::move(task));
+        m_backlog.fetch_add(1, std::memory_order_release);
+
+        // An idle strand has to be handed to the pool; a scheduled one will
+        // pick the task up on its current or next turn
+        if (!m_scheduled) {
+            m_scheduled = true;
+            needsSchedule = true;
+        }
+    }
+
+    if (needsSchedule) {
+        m_executor->schedule(shared_from_this());
+    }
+}
+
+void PipelineStrand::shutdown()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_closed = true;
+    m_backlog.fetch_sub(static_cast<int>(m_tasks.size()), std::memory_order_release);
+    m_tasks.clear();
+
+    while (m_running) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+bool PipelineStrand::runBatch()
+{
+    for (int i = 0; i < MAX_BATCH; ++i) {
+        Task task;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_closed || m_tasks.empty()) {
+                m_scheduled = false;
+                return false;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            m_running = true;
+        }
+
+        try {
+            task();
+        } catch (const std::exception &e) {
+            qWarning() << "Pipeline task failed:" << e.what();
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_running = false;
+            m_backlog.fetch_sub(1, std::memory_order_release);
+            m_idle.wakeAll();
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_closed || m_tasks.empty()) {
+        m_scheduled = false;
+        return false;
+    }
+
+    // Still busy: stay scheduled and go to the back of the line
+    return true;
+}
+
+// ============================================================================
+// PipelineExecutor Implementation
+// ============================================================================
+
+PipelineExecutor::PipelineExecutor(int threadCount)
+    : m_queuedStrands(0)
+    , m_nextQueue(0)
+    , m_stopping(false)
+{
+    if (threadCount <= 0) {
+        threadCount = qMax(1, QThread::idealThreadCount());
+    }
+
+    for (int i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for (int i = 0; i < threadCount; ++i) {
+        QThread *thread = QThread::create([this, i]() { workerLoop(i); });
+        thread->setObjectName(QString("PipelineWorker-%1").arg(i));
+        m_threads.append(thread);
+        thread->start();
+    }
+
+    qDebug() << "Pipeline executor started with" << threadCount << "worker threads";
+}
+
+PipelineExecutor::~PipelineExecutor()
+{
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_stopping.store(true, std::memory_order_release);
+        m_workAvailable.wakeAll();
+    }
+
+    for (QThread *thread : m_threads) {
+        thread->wait();
+        delete thread;
+    }
+    m_threads.clear();
+}
+
+std::shared_ptr<PipelineStrand> PipelineExecutor::createStrand()
+{
+    return std::shared_ptr<PipelineStrand>(new PipelineStrand(this));
+}
+
+void PipelineExecutor::schedule(std::shared_ptr<PipelineStrand> strand)
+{
+    // Pool threads keep rescheduled strands local (cache friendly); outside
+    // producers such as capture threads spread strands round-robin
+    int index = (t_currentExecutor == this) ? t_workerIndex
+        : static_cast<int>(m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size());
+
+    {
+        QMutexLocker locker(&m_queues[index]->mutex);
+        m_queues[index]->strands.push_back(std::move(strand));
+    }
+
+    // Publish under the sleep mutex so a worker checking for work before
+    // going to sleep cannot miss the wakeup
+    QMutexLocker locker(&m_sleepMutex);
+    m_queuedStrands.fetch_add(1, std::memory_order_release);
+    m_workAvailable.wakeOne();
+}
+
+std::shared_ptr<PipelineStrand> PipelineExecutor::takeWork(int workerIndex)
+{
+    const int queueCount = static_cast<int>(m_queues.size());
+
+    // Own queue first, oldest strand first
+    {
+        WorkQueue &own = *m_queues[workerIndex];
+        QMutexLocker locker(&own.mutex);
+        if (!own.strands.empty()) {
+            std::shared_ptr<PipelineStrand> strand = std::move(own.strands.front());
+            own.strands.pop_front();
+            m_queuedStrands.fetch_sub(1, std::memory_order_acq_rel);
+            return strand;
+        }
+    }
+
+    // Then steal from the back of the other queues
+    for (int offset = 1; offset < queueCount; ++offset) {
+        WorkQueue &victim = *m_queues[(workerIndex + offset) % queueCount];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.strands.empty()) {
+            std::shared_ptr<PipelineStrand> strand = std::move(victim.strands.back());
+            victim.strands.pop_back();
+            m_queuedStrands.fetch_sub(1, std::memory_order_acq_rel);
+            return strand;
+        }
+    }
+
+    return nullptr;
+}
+
+void PipelineExecutor::workerLoop(int workerIndex)
+{
+    t_currentExecutor = this;
+    t_workerIndex = workerIndex;
+
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        std::shared_ptr<PipelineStrand> strand = takeWork(workerIndex);
+
+        if (!strand) {
+            QMutexLocker locker(&m_sleepMutex);
+            if (m_queuedStrands.load(std::memory_order_acquire) <= 0 &&
+                !m_stopping.load(std::memory_order_acquire)) {
+                m_workAvailable.wait(&m_sleepMutex);
+            }
+            continue;
+        }
+
+        if (strand->runBatch()) {
+            schedule(std::move(strand));
+        }
+    }
+
+    t_currentExecutor = nullptr;
+    t_workerIndex = -1;
+}
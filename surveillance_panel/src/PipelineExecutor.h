@@ -0,0 +1,103 @@
+#ifndef PIPELINEEXECUTOR_H
+#define PIPELINEEXECUTOR_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class PipelineExecutor;
+
+/**
+ * @brief Serial task queue running on a PipelineExecutor
+ *
+ * Tasks posted to one strand run one at a time and in posting order, but
+ * on whichever pool thread picks the strand up. Each camera owns a strand,
+ * so its analysis state stays single-threaded without a dedicated thread.
+ */
+class PipelineStrand : public std::enable_shared_from_this<PipelineStrand>
+{
+public:
+    using Task = std::function<void()>;
+
+    // Queues a task; ignored once the strand has been shut down
+    void post(Task task);
+
+    // Number of tasks queued or running
+    int backlog() const { return m_backlog.load(std::memory_order_acquire); }
+
+    // Drops queued tasks, rejects new ones and waits for a running task to finish
+    void shutdown();
+
+private:
+    friend class PipelineExecutor;
+
+    explicit PipelineStrand(PipelineExecutor *executor);
+
+    // Runs up to MAX_BATCH tasks on the calling pool thread.
+    // Returns true if tasks remain and the strand must be rescheduled.
+    bool runBatch();
+
+    PipelineExecutor *m_executor;
+    QMutex m_mutex;
+    QWaitCondition m_idle;
+    std::deque<Task> m_tasks;
+    bool m_scheduled;   // Queued on the pool or currently running
+    bool m_running;     // A task is executing right now
+    bool m_closed;
+    std::atomic<int> m_backlog;
+
+    // Tasks run per turn before yielding the thread to other cameras
+    static constexpr int MAX_BATCH = 4;
+};
+
+/**
+ * @brief Fixed-size work-stealing thread pool for camera analysis stages
+ *
+ * Each pool thread owns a queue of runnable strands. A thread serves its
+ * own queue first and steals from the others when it runs dry, so busy
+ * cameras spread across all cores while the thread count stays at the
+ * core count regardless of how many cameras are configured.
+ */
+class PipelineExecutor
+{
+public:
+    // threadCount <= 0 sizes the pool to QThread::idealThreadCount()
+    explicit PipelineExecutor(int threadCount = 0);
+    ~PipelineExecutor();
+
+    PipelineExecutor(const PipelineExecutor &) = delete;
+    PipelineExecutor &operator=(const PipelineExecutor &) = delete;
+
+    std::shared_ptr<PipelineStrand> createStrand();
+
+    int threadCount() const { return m_threads.size(); }
+
+private:
+    friend class PipelineStrand;
+
+    struct WorkQueue {
+        QMutex mutex;
+        std::deque<std::shared_ptr<PipelineStrand>> strands;
+    };
+
+    void schedule(std::shared_ptr<PipelineStrand> strand);
+    std::shared_ptr<PipelineStrand> takeWork(int workerIndex);
+    void workerLoop(int workerIndex);
+
+    QVector<QThread*> m_threads;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    QMutex m_sleepMutex;
+    QWaitCondition m_workAvailable;
+    std::atomic<int> m_queuedStrands;
+    std::atomic<unsigned int> m_nextQueue;
+    std::atomic<bool> m_stopping;
+};
+
+#endif // PIPELINEEXECUTOR_H
@@ -0,0 +1,122 @@
+#include "PipelineMetrics.h"
+#include <cmath>
+
+namespace {
+// Bucket bounds in nanoseconds, matching bucketBounds()
+constexpr std::array<qint64, LatencyHistogram::BUCKET_COUNT> BOUNDS_NS = {
+    500000LL, 1000000LL, 2500000LL, 5000000LL, 10000000LL, 25000000LL,
+    50000000LL, 100000000LL, 250000000LL, 500000000LL, 1000000000LL, 2500000000LL
+};
+}
+
+LatencyHistogram::LatencyHistogram()
+    : m_sumNs(0)
+{
+    for (std::atomic<quint64> &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::observe(qint64 nanoseconds)
+{
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT && nanoseconds > BOUNDS_NS[bucket]) {
+        ++bucket;
+    }
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(static_cast<quint64>(qMax<qint64>(0, nanoseconds)), std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.count = 0;
+    for (int i = 0; i <= BUCKET_COUNT; ++i) {
+        snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.buckets[i];
+    }
+    snapshot.sumSeconds = m_sumNs.load(std::memory_order_relaxed) / 1e9;
+    return snapshot;
+}
+
+const std::array<double, LatencyHistogram::BUCKET_COUNT> &LatencyHistogram::bucketBounds()
+{
+    static const std::array<double, BUCKET_COUNT> bounds = {
+        0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5
+    };
+    return bounds;
+}
+
+void PrometheusWriter::family(const char *name, const char *type, const char *help)
+{
+    m_data.append("# HELP ").append(name).append(' ').append(help).append('\n');
+    m_data.append("# TYPE ").append(name).append(' ').append(type).append('\n');
+}
+
+void PrometheusWriter::sample(const char *name, double value, Labels labels)
+{
+    m_data.append(name).append(formatLabels(labels)).append(' ').append(formatValue(value)).append('\n');
+}
+
+void PrometheusWriter::histogram(const char *name, const LatencyHistogram &histogram, Labels labels)
+{
+    // Counted from the buckets, so _count always equals the +Inf bucket
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    const QByteArray bucketName = QByteArray(name) + "_bucket";
+
+    quint64 cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+        cumulative += snapshot.buckets[i];
+        const QByteArray le = "le=\"" + formatValue(LatencyHistogram::bucketBounds()[i]) + '"';
+        m_data.append(bucketName).append(formatLabels(labels, le)).append(' ')
+              .append(QByteArray::number(cumulative)).append('\n');
+    }
+    m_data.append(bucketName).append(formatLabels(labels, "le=\"+Inf\"")).append(' ')
+          .append(QByteArray::number(snapshot.count)).append('\n');
+
+    m_data.append(name).append("_sum").append(formatLabels(labels)).append(' ')
+          .append(formatValue(snapshot.sumSeconds)).append('\n');
+    m_data.append(name).append("_count").append(formatLabels(labels)).append(' ')
+          .append(QByteArray::number(snapshot.count)).append('\n');
+}
+
+QByteArray PrometheusWriter::formatLabels(Labels labels, const QByteArray &extra)
+{
+    if (labels.size() == 0 && extra.isEmpty()) {
+        return QByteArray();
+    }
+
+    QByteArray result = "{";
+    bool first = true;
+    for (const auto &label : labels) {
+        // Label values escape backslash, quote and newline
+        QString value = label.second;
+        value.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+
+        if (!first) {
+            result.append(',');
+        }
+        result.append(label.first).append("=\"").append(value.toUtf8()).append('"');
+        first = false;
+    }
+    if (!extra.isEmpty()) {
+        if (!first) {
+            result.append(',');
+        }
+        result.append(extra);
+    }
+    result.append('}');
+    return result;
+}
+
+QByteArray PrometheusWriter::formatValue(double value)
+{
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    return QByteArray::number(value, 'g', 12);
+}
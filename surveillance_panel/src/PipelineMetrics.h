@@ -0,0 +1,85 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QPair>
+#include <array>
+#include <atomic>
+#include <initializer_list>
+
+/**
+ * @brief Lock-free latency histogram with fixed Prometheus-style buckets
+ *
+ * Each histogram is written by the one thread running its stage (a capture
+ * thread, or whichever pool thread holds the camera's strand), so observe()
+ * is a handful of uncontended relaxed increments. A scrape may see a sample
+ * counted in its bucket before it shows up in the sum; Prometheus copes.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int BUCKET_COUNT = 12;     // Finite buckets; +Inf comes on top
+
+    struct Snapshot {
+        std::array<quint64, BUCKET_COUNT + 1> buckets;  // Per bucket, not cumulative
+        quint64 count;
+        double sumSeconds;
+    };
+
+    LatencyHistogram();
+
+    void observe(qint64 nanoseconds);
+    Snapshot snapshot() const;
+
+    // Upper bounds of the finite buckets, in seconds
+    static const std::array<double, BUCKET_COUNT> &bucketBounds();
+
+private:
+    std::array<std::atomic<quint64>, BUCKET_COUNT + 1> m_buckets;
+    std::atomic<quint64> m_sumNs;
+};
+
+/**
+ * @brief Per-camera pipeline counters, shared by the capture thread and the analysis strand
+ *
+ * The capture side and the analysis side are written by different threads,
+ * so each group starts on its own cache line.
+ */
+struct CameraMetrics {
+    // Capture thread
+    alignas(64) LatencyHistogram decode;        // Reading a frame, including waiting for the source
+    std::atomic<quint64> framesCaptured{0};
+    std::atomic<double> captureFps{0.0};
+
+    // Analysis strand
+    alignas(64) LatencyHistogram motion;
+    LatencyHistogram inference;                 // Object detector, including waiting for the network
+    LatencyHistogram postProcess;               // Tracking, line crossing and loitering
+    std::atomic<int> activeTracks{0};
+};
+
+/**
+ * @brief Builds a response in the Prometheus text exposition format
+ */
+class PrometheusWriter
+{
+public:
+    using Labels = std::initializer_list<QPair<const char *, QString>>;
+
+    // Starts a metric family; call once before its samples
+    void family(const char *name, const char *type, const char *help);
+
+    void sample(const char *name, double value, Labels labels = {});
+    void histogram(const char *name, const LatencyHistogram &histogram, Labels labels = {});
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    static QByteArray formatLabels(Labels labels, const QByteArray &extra = QByteArray());
+    static QByteArray formatValue(double value);
+
+    QByteArray m_data;
+};
+
+#endif // PIPELINEMETRICS_H
@@ -0,0 +1,534 @@
+#include "RoiOverlayItem.h"
+#include <QSGNode>
+#include <QSGGeometry>
+#include <QSGFlatColorMaterial>
+#include <QColor>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// Colors and sizes match the previous Canvas implementation
+const QColor ROI_FILL(52, 152, 219, 77);           // rgba(52, 152, 219, 0.3)
+const QColor ROI_STROKE("#3498db");
+const QColor ROI_ALERT_FILL(231, 76, 60, 102);     // rgba(231, 76, 60, 0.4)
+const QColor ALERT_COLOR("#e74c3c");
+const QColor TRIPWIRE_COLOR("#e67e22");
+const QColor EDIT_COLOR("#e74c3c");
+const QColor EDIT_BORDER_COLOR("#ffffff");
+
+constexpr qreal ROI_STROKE_WIDTH = 3.0;
+constexpr qreal ROI_ALERT_STROKE_WIDTH = 4.0;
+constexpr qreal TRIPWIRE_WIDTH = 4.0;
+constexpr qreal TRIPWIRE_ALERT_WIDTH = 6.0;
+constexpr qreal TRIPWIRE_ENDPOINT_RADIUS = 6.0;
+constexpr qreal TRIPWIRE_ALERT_ENDPOINT_RADIUS = 8.0;
+constexpr qreal EDIT_POINT_RADIUS = 6.0;
+constexpr qreal EDIT_BORDER_WIDTH = 2.0;
+constexpr qreal EDIT_DASH_LENGTH = 5.0;
+constexpr qreal EDIT_GAP_LENGTH = 3.0;
+
+/**
+ * @brief Root node holding one child layer per overlay element
+ */
+class OverlayRootNode : public QSGNode
+{
+public:
+    OverlayRootNode()
+        : roiLayer(new QSGOpacityNode)
+        , roiAlertLayer(new QSGOpacityNode)
+        , tripwireLayer(new QSGOpacityNode)
+        , tripwireAlertLayer(new QSGOpacityNode)
+        , editLayer(new QSGNode)
+    {
+        appendChildNode(roiLayer);
+        appendChildNode(roiAlertLayer);
+        appendChildNode(tripwireLayer);
+        appendChildNode(tripwireAlertLayer);
+        appendChildNode(editLayer);
+    }
+
+    QSGOpacityNode *roiLayer;
+    QSGOpacityNode *roiAlertLayer;
+    QSGOpacityNode *tripwireLayer;
+    QSGOpacityNode *tripwireAlertLayer;
+    QSGNode *editLayer;
+};
+
+void clearLayer(QSGNode *layer)
+{
+    while (QSGNode *child = layer->firstChild()) {
+        layer->removeChildNode(child);
+        delete child;
+    }
+}
+
+void appendTrianglesNode(QSGNode *layer, const QVector<QPointF> &triangles, const QColor &color)
+{
+    if (triangles.isEmpty()) {
+        return;
+    }
+
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), triangles.size());
+    geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+
+    QSGGeometry::Point2D *vertices = geometry->vertexDataAsPoint2D();
+    for (int i = 0; i < triangles.size(); ++i) {
+        vertices[i].set(static_cast<float>(triangles[i].x()),
+                        static_cast<float>(triangles[i].y()));
+    }
+
+    auto *material = new QSGFlatColorMaterial;
+    material->setColor(color);
+
+    auto *node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setFlag(QSGNode::OwnsGeometry);
+    node->setMaterial(material);
+    node->setFlag(QSGNode::OwnsMaterial);
+
+    layer->appendChildNode(node);
+}
+
+double cross(const QPointF &o, const QPointF &a, const QPointF &b)
+{
+    return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+bool pointInTriangle(const QPointF &p, const QPointF &a, const QPointF &b, const QPointF &c)
+{
+    double d1 = cross(a, b, p);
+    double d2 = cross(b, c, p);
+    double d3 = cross(c, a, p);
+
+    bool hasNeg = (d1 < 0) || (d2 < 0) || (d3 < 0);
+    bool hasPos = (d1 > 0) || (d2 > 0) || (d3 > 0);
+    return !(hasNeg && hasPos);
+}
+
+// Ear-clipping triangulation so concave ROI polygons fill correctly
+QVector<QPointF> triangulatePolygon(const QVector<QPointF> &polygon)
+{
+    QVector<QPointF> triangles;
+    const int n = polygon.size();
+    if (n < 3) {
+        return triangles;
+    }
+
+    // Orient the polygon so that convex corners have a positive cross product
+    double area = 0.0;
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+        area += polygon[j].x() * polygon[i].y() - polygon[i].x() * polygon[j].y();
+    }
+
+    QVector<int> indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    if (area < 0) {
+        std::reverse(indices.begin(), indices.end());
+    }
+
+    while (indices.size() > 3) {
+        const int m = indices.size();
+        bool clipped = false;
+
+        for (int i = 0; i < m; ++i) {
+            const QPointF &a = polygon[indices[(i + m - 1) % m]];
+            const QPointF &b = polygon[indices[i]];
+            const QPointF &c = polygon[indices[(i + 1) % m]];
+
+            if (cross(a, b, c) <= 0) {
+                continue;  // Reflex or degenerate corner
+            }
+
+            bool containsOther = false;
+            for (int k = 0; k < m && !containsOther; ++k) {
+                if (k == i || k == (i + m - 1) % m || k == (i + 1) % m) {
+                    continue;
+                }
+                containsOther = pointInTriangle(polygon[indices[k]], a, b, c);
+            }
+
+            if (!containsOther) {
+                triangles << a << b << c;
+                indices.removeAt(i);
+                clipped = true;
+                break;
+            }
+        }
+
+        if (!clipped) {
+            break;  // Self-intersecting polygon - fan the remainder below
+        }
+    }
+
+    for (int i = 1; i + 1 < indices.size(); ++i) {
+        triangles << polygon[indices[0]] << polygon[indices[i]] << polygon[indices[i + 1]];
+    }
+
+    return triangles;
+}
+
+void appendSegment(QVector<QPointF> &triangles, const QPointF &a, const QPointF &b, qreal width)
+{
+    QPointF d = b - a;
+    qreal length = std::hypot(d.x(), d.y());
+    if (length <= 0.0) {
+        return;
+    }
+
+    QPointF n(-d.y() / length * width / 2.0, d.x() / length * width / 2.0);
+    triangles << a + n << a - n << b + n
+              << b + n << a - n << b - n;
+}
+
+void appendDisc(QVector<QPointF> &triangles, const QPointF &center, qreal radius)
+{
+    constexpr int SEGMENTS = 16;
+
+    for (int i = 0; i < SEGMENTS; ++i) {
+        qreal a0 = 2.0 * M_PI * i / SEGMENTS;
+        qreal a1 = 2.0 * M_PI * (i + 1) / SEGMENTS;
+        triangles << center
+                  << center + QPointF(std::cos(a0) * radius, std::sin(a0) * radius)
+                  << center + QPointF(std::cos(a1) * radius, std::sin(a1) * radius);
+    }
+}
+
+void appendDashedSegment(QVector<QPointF> &triangles, const QPointF &a, const QPointF &b, qreal width)
+{
+    QPointF d = b - a;
+    qreal length = std::hypot(d.x(), d.y());
+    if (length <= 0.0) {
+        return;
+    }
+
+    QPointF dir = d / length;
+    for (qreal t = 0.0; t < length; t += EDIT_DASH_LENGTH + EDIT_GAP_LENGTH) {
+        qreal end = std::min(t + EDIT_DASH_LENGTH, length);
+        appendSegment(triangles, a + dir * t, a + dir * end, width);
+    }
+}
+
+// Closed outline with round joins
+QVector<QPointF> strokePolygon(const QVector<QPointF> &polygon, qreal width)
+{
+    QVector<QPointF> triangles;
+    const int n = polygon.size();
+
+    for (int i = 0; i < n; ++i) {
+        appendSegment(triangles, polygon[i], polygon[(i + 1) % n], width);
+        appendDisc(triangles, polygon[i], width / 2.0);
+    }
+
+    return triangles;
+}
+
+QVector<QPointF> tripwireTriangles(const QPointF &start, const QPointF &end, qreal width, qreal endpointRadius)
+{
+    QVector<QPointF> triangles;
+    appendSegment(triangles, start, end, width);
+    appendDisc(triangles, start, endpointRadius);
+    appendDisc(triangles, end, endpointRadius);
+    return triangles;
+}
+
+} // namespace
+
+RoiOverlayItem::RoiOverlayItem(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_hasTripwire(false)
+    , m_hasEditTripwireStart(false)
+    , m_roiEditMode(false)
+    , m_tripwireEditMode(false)
+    , m_roiAlertActive(false)
+    , m_tripwireAlertActive(false)
+    , m_alertPulse(1.0)
+    , m_dirty(ShapeDirty | EditDirty | StateDirty)
+{
+    setFlag(ItemHasContents, true);
+}
+
+QPointF RoiOverlayItem::toPoint(const QVariant &value)
+{
+    QVariantMap map = value.toMap();
+    return QPointF(map.value("x").toDouble(), map.value("y").toDouble());
+}
+
+void RoiOverlayItem::setRoiPoints(const QVariantList &points)
+{
+    if (m_roiPointsVar == points) {
+        return;
+    }
+
+    m_roiPointsVar = points;
+    m_roiNorm.clear();
+    for (const QVariant &point : points) {
+        m_roiNorm.append(toPoint(point));
+    }
+
+    markDirty(ShapeDirty);
+    emit roiPointsChanged();
+}
+
+void RoiOverlayItem::setTripwire(const QVariantMap &tripwire)
+{
+    if (m_tripwireVar == tripwire) {
+        return;
+    }
+
+    m_tripwireVar = tripwire;
+    m_hasTripwire = tripwire.value("has").toBool();
+    m_tripwireStartNorm = QPointF(tripwire.value("startX").toDouble(), tripwire.value("startY").toDouble());
+    m_tripwireEndNorm = QPointF(tripwire.value("endX").toDouble(), tripwire.value("endY").toDouble());
+
+    markDirty(ShapeDirty);
+    emit tripwireChanged();
+}
+
+void RoiOverlayItem::setRoiEditMode(bool enabled)
+{
+    if (m_roiEditMode == enabled) {
+        return;
+    }
+
+    m_roiEditMode = enabled;
+    markDirty(EditDirty | StateDirty);
+    emit roiEditModeChanged();
+}
+
+void RoiOverlayItem::setTripwireEditMode(bool enabled)
+{
+    if (m_tripwireEditMode == enabled) {
+        return;
+    }
+
+    m_tripwireEditMode = enabled;
+    markDirty(EditDirty | StateDirty);
+    emit tripwireEditModeChanged();
+}
+
+void RoiOverlayItem::setEditPoints(const QVariantList &points)
+{
+    m_editPointsVar = points;
+    m_editPoints.clear();
+    for (const QVariant &point : points) {
+        m_editPoints.append(toPoint(point));
+    }
+
+    markDirty(EditDirty);
+    emit editPointsChanged();
+}
+
+void RoiOverlayItem::setHasEditTripwireStart(bool has)
+{
+    if (m_hasEditTripwireStart == has) {
+        return;
+    }
+
+    m_hasEditTripwireStart = has;
+    markDirty(EditDirty);
+    emit editTripwireStartChanged();
+}
+
+void RoiOverlayItem::setEditTripwireStart(const QPointF &start)
+{
+    if (m_editTripwireStart == start) {
+        return;
+    }
+
+    m_editTripwireStart = start;
+    markDirty(EditDirty);
+    emit editTripwireStartChanged();
+}
+
+void RoiOverlayItem::setCursorPos(const QPointF &pos)
+{
+    if (m_cursorPos == pos) {
+        return;
+    }
+
+    m_cursorPos = pos;
+
+    // The cursor only matters while previewing a tripwire
+    if (tripwireEditPreviewVisible()) {
+        markDirty(EditDirty);
+    }
+    emit cursorPosChanged();
+}
+
+void RoiOverlayItem::setRoiAlertActive(bool active)
+{
+    if (m_roiAlertActive == active) {
+        return;
+    }
+
+    m_roiAlertActive = active;
+    markDirty(StateDirty);
+    emit roiAlertActiveChanged();
+}
+
+void RoiOverlayItem::setTripwireAlertActive(bool active)
+{
+    if (m_tripwireAlertActive == active) {
+        return;
+    }
+
+    m_tripwireAlertActive = active;
+    markDirty(StateDirty);
+    emit tripwireAlertActiveChanged();
+}
+
+void RoiOverlayItem::setAlertPulse(qreal pulse)
+{
+    pulse = qBound(0.0, pulse, 1.0);
+
+    if (qFuzzyCompare(m_alertPulse, pulse)) {
+        return;
+    }
+
+    m_alertPulse = pulse;
+
+    // Pulsing only touches layer opacity, never geometry
+    if (m_roiAlertActive || m_tripwireAlertActive) {
+        markDirty(StateDirty);
+    }
+    emit alertPulseChanged();
+}
+
+void RoiOverlayItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+
+    // Stored shapes are normalized and have to be rescaled
+    if (newGeometry.size() != oldGeometry.size()) {
+        markDirty(ShapeDirty);
+    }
+}
+
+void RoiOverlayItem::markDirty(int flags)
+{
+    m_dirty |= flags;
+    update();
+}
+
+bool RoiOverlayItem::tripwireEditPreviewVisible() const
+{
+    return m_tripwireEditMode && m_hasEditTripwireStart;
+}
+
+QSGNode *RoiOverlayItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data);
+
+    auto *root = static_cast<OverlayRootNode *>(oldNode);
+    if (!root) {
+        root = new OverlayRootNode;
+        m_dirty = ShapeDirty | EditDirty | StateDirty;
+    }
+
+    if (m_dirty & ShapeDirty) {
+        rebuildShapeLayers(root);
+    }
+    if (m_dirty & EditDirty) {
+        rebuildEditLayer(root);
+    }
+    if (m_dirty & (ShapeDirty | StateDirty)) {
+        updateLayerOpacities(root);
+    }
+
+    m_dirty = 0;
+    return root;
+}
+
+void RoiOverlayItem::rebuildShapeLayers(QSGNode *node)
+{
+    auto *root = static_cast<OverlayRootNode *>(node);
+    const qreal w = width();
+    const qreal h = height();
+
+    clearLayer(root->roiLayer);
+    clearLayer(root->roiAlertLayer);
+    clearLayer(root->tripwireLayer);
+    clearLayer(root->tripwireAlertLayer);
+
+    if (m_roiNorm.size() >= 3) {
+        QVector<QPointF> polygon;
+        polygon.reserve(m_roiNorm.size());
+        for (const QPointF &p : m_roiNorm) {
+            polygon.append(QPointF(p.x() * w, p.y() * h));
+        }
+
+        QVector<QPointF> fill = triangulatePolygon(polygon);
+
+        appendTrianglesNode(root->roiLayer, fill, ROI_FILL);
+        appendTrianglesNode(root->roiLayer, strokePolygon(polygon, ROI_STROKE_WIDTH), ROI_STROKE);
+
+        appendTrianglesNode(root->roiAlertLayer, fill, ROI_ALERT_FILL);
+        appendTrianglesNode(root->roiAlertLayer, strokePolygon(polygon, ROI_ALERT_STROKE_WIDTH), ALERT_COLOR);
+    }
+
+    if (m_hasTripwire) {
+        QPointF start(m_tripwireStartNorm.x() * w, m_tripwireStartNorm.y() * h);
+        QPointF end(m_tripwireEndNorm.x() * w, m_tripwireEndNorm.y() * h);
+
+        appendTrianglesNode(root->tripwireLayer,
+                            tripwireTriangles(start, end, TRIPWIRE_WIDTH, TRIPWIRE_ENDPOINT_RADIUS),
+                            TRIPWIRE_COLOR);
+        appendTrianglesNode(root->tripwireAlertLayer,
+                            tripwireTriangles(start, end, TRIPWIRE_ALERT_WIDTH, TRIPWIRE_ALERT_ENDPOINT_RADIUS),
+                            ALERT_COLOR);
+    }
+}
+
+void RoiOverlayItem::rebuildEditLayer(QSGNode *node)
+{
+    auto *root = static_cast<OverlayRootNode *>(node);
+    clearLayer(root->editLayer);
+
+    QVector<QPointF> lines;
+    QVector<QPointF> pointBorders;
+    QVector<QPointF> points;
+
+    auto appendEditPoint = [&](const QPointF &p) {
+        appendDisc(pointBorders, p, EDIT_POINT_RADIUS + EDIT_BORDER_WIDTH / 2.0);
+        appendDisc(points, p, EDIT_POINT_RADIUS - EDIT_BORDER_WIDTH / 2.0);
+    };
+
+    if (m_roiEditMode && !m_editPoints.isEmpty()) {
+        if (m_editPoints.size() > 1) {
+            for (int i = 0; i < m_editPoints.size(); ++i) {
+                // Includes the preview edge back to the first point
+                appendDashedSegment(lines, m_editPoints[i],
+                                    m_editPoints[(i + 1) % m_editPoints.size()], 2.0);
+            }
+        }
+        for (const QPointF &p : m_editPoints) {
+            appendEditPoint(p);
+        }
+    }
+
+    if (tripwireEditPreviewVisible()) {
+        appendDashedSegment(lines, m_editTripwireStart, m_cursorPos, 3.0);
+        appendEditPoint(m_editTripwireStart);
+    }
+
+    appendTrianglesNode(root->editLayer, lines, EDIT_COLOR);
+    appendTrianglesNode(root->editLayer, pointBorders, EDIT_BORDER_COLOR);
+    appendTrianglesNode(root->editLayer, points, EDIT_COLOR);
+}
+
+void RoiOverlayItem::updateLayerOpacities(QSGNode *node)
+{
+    auto *root = static_cast<OverlayRootNode *>(node);
+
+    // Stored shapes are hidden while the same shape is being edited
+    const bool showRoi = !m_roiEditMode;
+    const bool showTripwire = !m_tripwireEditMode;
+
+    root->roiLayer->setOpacity(showRoi && !m_roiAlertActive ? 1.0 : 0.0);
+    root->roiAlertLayer->setOpacity(showRoi && m_roiAlertActive ? m_alertPulse : 0.0);
+    root->tripwireLayer->setOpacity(showTripwire && !m_tripwireAlertActive ? 1.0 : 0.0);
+    root->tripwireAlertLayer->setOpacity(showTripwire && m_tripwireAlertActive ? m_alertPulse : 0.0);
+}
@@ -0,0 +1,133 @@
+#ifndef ROIOVERLAYITEM_H
+#define ROIOVERLAYITEM_H
+
+#include <QQuickItem>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QPointF>
+#include <QVector>
+#include <QtQml/qqmlregistration.h>
+
+class QSGNode;
+
+/**
+ * @brief Scene-graph item that draws the ROI polygon and tripwire of a camera tile
+ *
+ * Geometry is only rebuilt when the shape, the item size or the edit state
+ * changes. Alert highlighting switches between prebuilt layers and pulses
+ * their opacity, so an active alert never re-tessellates anything.
+ */
+class RoiOverlayItem : public QQuickItem
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    // Stored shapes in normalized [0,1] coordinates (as returned by CameraManager)
+    Q_PROPERTY(QVariantList roiPoints READ roiPoints WRITE setRoiPoints NOTIFY roiPointsChanged)
+    Q_PROPERTY(QVariantMap tripwire READ tripwire WRITE setTripwire NOTIFY tripwireChanged)
+
+    // In-progress editing data in item pixel coordinates
+    Q_PROPERTY(bool roiEditMode READ roiEditMode WRITE setRoiEditMode NOTIFY roiEditModeChanged)
+    Q_PROPERTY(bool tripwireEditMode READ tripwireEditMode WRITE setTripwireEditMode NOTIFY tripwireEditModeChanged)
+    Q_PROPERTY(QVariantList editPoints READ editPoints WRITE setEditPoints NOTIFY editPointsChanged)
+    Q_PROPERTY(bool hasEditTripwireStart READ hasEditTripwireStart WRITE setHasEditTripwireStart NOTIFY editTripwireStartChanged)
+    Q_PROPERTY(QPointF editTripwireStart READ editTripwireStart WRITE setEditTripwireStart NOTIFY editTripwireStartChanged)
+    Q_PROPERTY(QPointF cursorPos READ cursorPos WRITE setCursorPos NOTIFY cursorPosChanged)
+
+    // Alert highlighting
+    Q_PROPERTY(bool roiAlertActive READ roiAlertActive WRITE setRoiAlertActive NOTIFY roiAlertActiveChanged)
+    Q_PROPERTY(bool tripwireAlertActive READ tripwireAlertActive WRITE setTripwireAlertActive NOTIFY tripwireAlertActiveChanged)
+    Q_PROPERTY(qreal alertPulse READ alertPulse WRITE setAlertPulse NOTIFY alertPulseChanged)
+
+public:
+    explicit RoiOverlayItem(QQuickItem *parent = nullptr);
+
+    QVariantList roiPoints() const { return m_roiPointsVar; }
+    void setRoiPoints(const QVariantList &points);
+
+    QVariantMap tripwire() const { return m_tripwireVar; }
+    void setTripwire(const QVariantMap &tripwire);
+
+    bool roiEditMode() const { return m_roiEditMode; }
+    void setRoiEditMode(bool enabled);
+
+    bool tripwireEditMode() const { return m_tripwireEditMode; }
+    void setTripwireEditMode(bool enabled);
+
+    QVariantList editPoints() const { return m_editPointsVar; }
+    void setEditPoints(const QVariantList &points);
+
+    bool hasEditTripwireStart() const { return m_hasEditTripwireStart; }
+    void setHasEditTripwireStart(bool has);
+
+    QPointF editTripwireStart() const { return m_editTripwireStart; }
+    void setEditTripwireStart(const QPointF &start);
+
+    QPointF cursorPos() const { return m_cursorPos; }
+    void setCursorPos(const QPointF &pos);
+
+    bool roiAlertActive() const { return m_roiAlertActive; }
+    void setRoiAlertActive(bool active);
+
+    bool tripwireAlertActive() const { return m_tripwireAlertActive; }
+    void setTripwireAlertActive(bool active);
+
+    qreal alertPulse() const { return m_alertPulse; }
+    void setAlertPulse(qreal pulse);
+
+signals:
+    void roiPointsChanged();
+    void tripwireChanged();
+    void roiEditModeChanged();
+    void tripwireEditModeChanged();
+    void editPointsChanged();
+    void editTripwireStartChanged();
+    void cursorPosChanged();
+    void roiAlertActiveChanged();
+    void tripwireAlertActiveChanged();
+    void alertPulseChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    // Which parts of the scene graph have to be rebuilt on the next sync
+    enum DirtyFlag {
+        ShapeDirty = 0x1,   // Stored ROI/tripwire geometry
+        EditDirty  = 0x2,   // In-progress editing geometry
+        StateDirty = 0x4    // Layer opacities only
+    };
+
+    void markDirty(int flags);
+    bool tripwireEditPreviewVisible() const;
+
+    void rebuildShapeLayers(QSGNode *root);
+    void rebuildEditLayer(QSGNode *root);
+    void updateLayerOpacities(QSGNode *root);
+
+    static QPointF toPoint(const QVariant &value);
+
+    QVariantList m_roiPointsVar;
+    QVariantMap m_tripwireVar;
+    QVariantList m_editPointsVar;
+
+    QVector<QPointF> m_roiNorm;
+    bool m_hasTripwire;
+    QPointF m_tripwireStartNorm;
+    QPointF m_tripwireEndNorm;
+    QVector<QPointF> m_editPoints;
+    bool m_hasEditTripwireStart;
+    QPointF m_editTripwireStart;
+    QPointF m_cursorPos;
+
+    bool m_roiEditMode;
+    bool m_tripwireEditMode;
+    bool m_roiAlertActive;
+    bool m_tripwireAlertActive;
+    qreal m_alertPulse;
+
+    int m_dirty;
+};
+
+#endif // ROIOVERLAYITEM_H
@@ -2,14 +2,22 @@
 #include "AlertLogModel.h"
 #include "CameraManager.h"
 #include "CameraStream.h"
+#include "AlertStore.h"
+#include "JpegFrameCache.h"
+#include "MosaicComposer.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
 #include <QFileInfo>
-#include <QBuffer>
+#include <QPointer>
+#include <QThread>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QDateTime>
 #include <QDebug>
 #include <opencv2/opencv.hpp>
+#include <cmath>
 
 HttpServer::HttpServer(QObject *parent)
     : QObject(parent)
@@ -18,18 +26,51 @@ HttpServer::HttpServer(QObject *parent)
     , m_cameraManager(nullptr)
     , m_running(false)
     , m_port(0)
+    , m_idleTimer(new QTimer(this))
+    , m_requestsPerSecond(DEFAULT_REQUESTS_PER_SECOND)
+    , m_requestBurst(DEFAULT_REQUEST_BURST)
+    , m_frameCache(new JpegFrameCache(this))
+    , m_lastAlertSeq(-1)
+    , m_heartbeatTimer(new QTimer(this))
+    , m_etagEpoch(QDateTime::currentMSecsSinceEpoch())
 {
     connect(m_tcpServer, &QTcpServer::newConnection, this, &HttpServer::onNewConnection);
+    
+    m_idleTimer->setInterval(IDLE_CHECK_INTERVAL_MS);
+    connect(m_idleTimer, &QTimer::timeout, this, &HttpServer::closeIdleConnections);
+    m_clock.start();
+    
+    m_heartbeatTimer->setInterval(EVENT_HEARTBEAT_INTERVAL_MS);
+    connect(m_heartbeatTimer, &QTimer::timeout, this, &HttpServer::sendEventHeartbeats);
+    
+    m_workerPool.setMaxThreadCount(WORKER_THREADS);
+    
+    // Workers read the alert history through a connection per thread;
+    // keeping them alive keeps those connections open between requests
+    m_workerPool.setExpiryTimeout(-1);
+    m_snapshotCache.setMaxCost(SNAPSHOT_CACHE_KB);
 }
 
 HttpServer::~HttpServer()
 {
     stop();
+    
+    // Workers post their responses back to this object
+    m_workerPool.waitForDone();
 }
 
 void HttpServer::setAlertLogModel(AlertLogModel *model)
 {
+    if (m_alertLogModel) {
+        disconnect(m_alertLogModel, nullptr, this, nullptr);
+    }
+    
     m_alertLogModel = model;
+    
+    // Queued to the server's thread once it has been moved there
+    if (m_alertLogModel) {
+        connect(m_alertLogModel, &AlertLogModel::alertAdded, this, &HttpServer::onAlertAdded);
+    }
 }
 
 void HttpServer::setCameraManager(CameraManager *manager)
@@ -39,8 +80,17 @@ void HttpServer::setCameraManager(CameraManager *manager)
 
 bool HttpServer::start(quint16 port)
 {
-    if (m_running) {
-        qWarning() << "HTTP server already running on port" << m_port;
+    // The listening socket belongs to the server's thread
+    if (QThread::currentThread() != thread()) {
+        bool started = false;
+        QMetaObject::invokeMethod(this, [this, port]() {
+            return start(port);
+        }, Qt::BlockingQueuedConnection, &started);
+        return started;
+    }
+    
+    if (isRunning()) {
+        qWarning() << "HTTP server already running on port" << this->port();
         return false;
     }
 
@@ -50,24 +100,35 @@ bool HttpServer::start(quint16 port)
         return false;
     }
 
-    m_running = true;
-    m_port = m_tcpServer->serverPort();
+    m_port.store(m_tcpServer->serverPort(), std::memory_order_release);
+    m_running.store(true, std::memory_order_release);
+    m_idleTimer->start();
+    m_heartbeatTimer->start();
     
-    qDebug() << "✓ HTTP server started on port" << m_port;
-    emit serverStarted(m_port);
+    qDebug() << "✓ HTTP server started on port" << this->port();
+    emit serverStarted(this->port());
     
     return true;
 }
 
 void HttpServer::stop()
 {
-    if (!m_running) {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this]() {
+            stop();
+        }, Qt::BlockingQueuedConnection);
+        return;
+    }
+    
+    if (!isRunning()) {
         return;
     }
 
     m_tcpServer->close();
-    m_running = false;
-    m_port = 0;
+    m_idleTimer->stop();
+    m_heartbeatTimer->stop();
+    m_running.store(false, std::memory_order_release);
+    m_port.store(0, std::memory_order_release);
     
     qDebug() << "HTTP server stopped";
     emit serverStopped();
@@ -77,12 +138,71 @@ void HttpServer::onNewConnection()
 {
     while (m_tcpServer->hasPendingConnections()) {
         QTcpSocket *socket = m_tcpServer->nextPendingConnection();
+        const QHostAddress peer = socket->peerAddress();
+        
+        if (m_connections.count() >= MAX_CONNECTIONS) {
+            rejectConnection(socket, "server_full");
+            continue;
+        }
+        if (m_connectionsPerAddress.value(peer) >= MAX_CONNECTIONS_PER_ADDRESS) {
+            rejectConnection(socket, "per_address_limit");
+            continue;
+        }
+        
+        // Unread data stays in the kernel, so a fast sender is slowed by TCP
+        socket->setReadBufferSize(SOCKET_READ_BUFFER_BYTES);
         
         connect(socket, &QTcpSocket::readyRead, this, &HttpServer::onReadyRead);
         connect(socket, &QTcpSocket::disconnected, this, &HttpServer::onDisconnected);
+        connect(socket, &QTcpSocket::bytesWritten, this, &HttpServer::onBytesWritten);
         
-        m_pendingData[socket] = QByteArray();
+        ClientConnection &connection = m_connections[socket];
+        connection.peer = peer;
+        connection.idleSinceMs = m_clock.elapsed();
+        m_connectionsPerAddress[peer]++;
+    }
+}
+
+void HttpServer::rejectConnection(QTcpSocket *socket, const char *reason)
+{
+    m_rejectedConnections[reason]++;
+    qWarning() << "Rejecting HTTP connection from" << socket->peerAddress() << "-" << reason;
+    
+    // Never tracked; nothing is read from it
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    
+    Response response = errorResponse(503, "Service Unavailable");
+    response.headers.append({ "Retry-After", "5" });
+    sendResponse(socket, response);
+    socket->disconnectFromHost();
+}
+
+void HttpServer::setRateLimit(double requestsPerSecond, double burst)
+{
+    m_requestsPerSecond = qMax(requestsPerSecond, 0.001);
+    m_requestBurst = qMax(burst, 1.0);
+    m_rateBuckets.clear();
+}
+
+bool HttpServer::admitRequest(const QHostAddress &address, int *retryAfterSeconds)
+{
+    const qint64 now = m_clock.elapsed();
+    
+    auto it = m_rateBuckets.find(address);
+    if (it == m_rateBuckets.end()) {
+        it = m_rateBuckets.insert(address, RateBucket{ m_requestBurst, now });
+    }
+    
+    it->tokens = qMin(m_requestBurst, it->tokens + (now - it->refilledMs) * m_requestsPerSecond / 1000.0);
+    it->refilledMs = now;
+    
+    if (it->tokens >= 1.0) {
+        it->tokens -= 1.0;
+        return true;
     }
+    
+    *retryAfterSeconds = qMax(1, static_cast<int>(std::ceil((1.0 - it->tokens) / m_requestsPerSecond)));
+    return false;
 }
 
 void HttpServer::onReadyRead()
@@ -92,372 +212,1228 @@ void HttpServer::onReadyRead()
         return;
     }
 
-    // Accumulate data
-    m_pendingData[socket].append(socket->readAll());
-    
-    // Check if we have a complete HTTP request (ends with \r\n\r\n)
-    if (!m_pendingData[socket].contains("\r\n\r\n")) {
-        return;  // Wait for more data
+    // A streaming connection has nothing more to say
+    if (m_streamClients.contains(socket) || m_eventClients.contains(socket)) {
+        socket->readAll();
+        return;
     }
 
-    QString method;
-    QString path;
-    QMap<QString, QString> headers;
-    
-    if (!parseHttpRequest(m_pendingData[socket], method, path, headers)) {
-        sendError(socket, 400, "Bad Request");
-        socket->disconnectFromHost();
-        m_pendingData.remove(socket);
+    if (!m_connections.contains(socket)) {
+        socket->readAll();
         return;
     }
     
-    // Clear pending data for this socket
-    m_pendingData.remove(socket);
-    
-    emit requestReceived(method, path);
-    qDebug() << "HTTP" << method << path;
-    
-    handleRequest(socket, method, path, headers);
+    // Reads as much as the connection's buffer has room for
+    processRequests(socket);
 }
 
 void HttpServer::onDisconnected()
 {
     QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
     if (socket) {
-        m_pendingData.remove(socket);
+        auto it = m_connections.find(socket);
+        if (it != m_connections.end()) {
+            if (--m_connectionsPerAddress[it->peer] <= 0) {
+                m_connectionsPerAddress.remove(it->peer);
+            }
+            m_connections.erase(it);
+        }
+        removeStreamClient(socket);
+        m_eventClients.remove(socket);
         socket->deleteLater();
     }
 }
 
-bool HttpServer::parseHttpRequest(const QByteArray &data, QString &method, 
-                                  QString &path, QMap<QString, QString> &headers)
+void HttpServer::processRequests(QTcpSocket *socket)
+{
+    // One request at a time per connection, so pipelined responses stay in
+    // order. Looked up again every round: a handler may close the connection.
+    for (;;) {
+        auto it = m_connections.find(socket);
+        if (it == m_connections.end()) {
+            return;
+        }
+        
+        // Kept as raw bytes; the parser only looks at what is new. Whatever
+        // does not fit stays with the socket until requests are consumed.
+        const qint64 room = MAX_BUFFERED_BYTES - it->buffer.size();
+        if (room > 0 && socket->bytesAvailable() > 0) {
+            if (it->buffer.isEmpty()) {
+                it->requestStartMs = m_clock.elapsed();
+            }
+            it->buffer.append(socket->read(room));
+        }
+        
+        if (it->responding || it->closeAfterResponse || it->buffer.isEmpty()) {
+            return;
+        }
+        
+        // A client not reading its responses gets no more until it catches up
+        if (socket->bytesToWrite() > MAX_WRITE_BACKLOG_BYTES) {
+            return;
+        }
+        
+        HttpRequest request;
+        const HttpRequestParser::Result result = it->parser.parse(it->buffer, &request);
+        
+        if (result == HttpRequestParser::Result::Incomplete) {
+            return;
+        }
+        
+        it->responding = true;
+        it->dispatchedAtNs = m_clock.nsecsElapsed();
+        
+        if (result == HttpRequestParser::Result::Failed) {
+            it->closeAfterResponse = true;
+            it->buffer.clear();
+            sendError(socket, it->parser.errorStatus(), it->parser.errorMessage());
+            finishResponse(socket);
+            return;
+        }
+        
+        it->requestsServed++;
+        it->closeAfterResponse = !request.keepAlive() ||
+                                 it->requestsServed >= MAX_REQUESTS_PER_CONNECTION;
+        
+        // A pipelined request behind this one has been waiting since now
+        if (!it->buffer.isEmpty()) {
+            it->requestStartMs = m_clock.elapsed();
+        }
+        
+        int retryAfter = 0;
+        if (!admitRequest(it->peer, &retryAfter)) {
+            Response response = errorResponse(429, "Too Many Requests");
+            response.headers.append({ "Retry-After", QByteArray::number(retryAfter) });
+            sendResponse(socket, response);
+            finishResponse(socket);
+            continue;
+        }
+        
+        emit requestReceived(request.method, request.target);
+        qDebug() << "HTTP" << request.method << request.target;
+        
+        handleRequest(socket, request);
+    }
+}
+
+void HttpServer::finishResponse(QTcpSocket *socket)
 {
-    QString request = QString::fromUtf8(data);
-    QStringList lines = request.split("\r\n");
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) {
+        return;
+    }
     
-    if (lines.isEmpty()) {
-        return false;
+    if (it->responding) {
+        m_requestLatency.observe(m_clock.nsecsElapsed() - it->dispatchedAtNs);
     }
     
-    // Parse request line: "GET /path HTTP/1.1"
-    QStringList requestLine = lines[0].split(" ");
-    if (requestLine.size() < 2) {
-        return false;
+    if (it->closeAfterResponse) {
+        socket->disconnectFromHost();
+        return;
     }
     
-    method = requestLine[0];
-    path = requestLine[1];
+    it->responding = false;
+    it->idleSinceMs = m_clock.elapsed();
+    
+    // A response finished asynchronously may have requests queued behind it,
+    // or left unread with the socket; a synchronous one simply returns to the
+    // loop in processRequests
+    if (!it->buffer.isEmpty() || socket->bytesAvailable() > 0) {
+        QPointer<QTcpSocket> guard(socket);
+        QMetaObject::invokeMethod(this, [this, guard]() {
+            if (guard) {
+                processRequests(guard);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void HttpServer::closeIdleConnections()
+{
+    const qint64 now = m_clock.elapsed();
+    QVector<QTcpSocket*> idle;
+    QVector<QTcpSocket*> timedOut;
     
-    // Parse headers
-    for (int i = 1; i < lines.size(); ++i) {
-        if (lines[i].isEmpty()) {
-            break;
+    for (auto it = m_connections.cbegin(); it != m_connections.cend(); ++it) {
+        const ClientConnection &connection = it.value();
+        if (connection.responding) {
+            continue;
         }
         
-        int colonPos = lines[i].indexOf(':');
-        if (colonPos > 0) {
-            QString key = lines[i].left(colonPos).trimmed();
-            QString value = lines[i].mid(colonPos + 1).trimmed();
-            headers[key] = value;
+        if (connection.buffer.isEmpty()) {
+            if (now - connection.idleSinceMs > KEEP_ALIVE_TIMEOUT_MS) {
+                idle.append(it.key());
+            }
+        } else if (now - connection.requestStartMs > REQUEST_TIMEOUT_MS) {
+            timedOut.append(it.key());
         }
     }
     
-    return true;
+    // Closed outside the loop; disconnected() may be emitted right away
+    for (QTcpSocket *socket : idle) {
+        socket->disconnectFromHost();
+    }
+    
+    for (QTcpSocket *socket : timedOut) {
+        auto it = m_connections.find(socket);
+        if (it == m_connections.end()) {
+            continue;
+        }
+        it->responding = true;
+        it->dispatchedAtNs = m_clock.nsecsElapsed();
+        it->closeAfterResponse = true;
+        it->buffer.clear();
+        sendError(socket, 408, "Request Timeout");
+        finishResponse(socket);
+    }
+    
+    // A bucket that has refilled is no different from a fresh one
+    for (auto it = m_rateBuckets.begin(); it != m_rateBuckets.end();) {
+        const double tokens = it->tokens + (now - it->refilledMs) * m_requestsPerSecond / 1000.0;
+        if (tokens >= m_requestBurst && !m_connectionsPerAddress.contains(it.key())) {
+            it = m_rateBuckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
-void HttpServer::handleRequest(QTcpSocket *socket, const QString &method, 
-                              const QString &path, const QMap<QString, QString> &headers)
+void HttpServer::onBytesWritten()
 {
-    Q_UNUSED(headers);
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket) {
+        return;
+    }
     
-    if (method != "GET") {
+    // A stream viewer that skipped frames gets the latest one once drained
+    auto client = m_streamClients.find(socket);
+    if (client != m_streamClients.end()) {
+        if (client->waiting && socket->bytesToWrite() == 0) {
+            client->waiting = false;
+            catchUpStreamClient(socket);
+        }
+        return;
+    }
+    
+    // Requests held back while the client was not reading its responses
+    auto it = m_connections.constFind(socket);
+    if (it != m_connections.cend() && !it->responding && !it->buffer.isEmpty() &&
+        socket->bytesToWrite() <= MAX_WRITE_BACKLOG_BYTES) {
+        processRequests(socket);
+    }
+}
+
+void HttpServer::handleRequest(QTcpSocket *socket, const HttpRequest &request)
+{
+    if (request.method != "GET") {
         sendError(socket, 405, "Method Not Allowed");
-        socket->disconnectFromHost();
+        finishResponse(socket);
         return;
     }
     
+    // Split off the query string
+    const QString &path = request.target;
+    QUrl url(path);
+    QUrlQuery query(url);
+    
     // Route handling
     if (path == "/ping") {
         handlePing(socket);
     }
-    else if (path == "/alerts") {
-        handleGetAlerts(socket);
+    else if (url.path() == "/alerts") {
+        handleGetAlerts(socket, request, query);
     }
-    else if (path.startsWith("/alerts/") && path.endsWith("/snapshot")) {
+    else if (url.path() == "/alerts/stream") {
+        handleGetAlertStream(socket, request, query);
+    }
+    else if (url.path().startsWith("/alerts/") && url.path().endsWith("/snapshot")) {
         // Extract alert ID: /alerts/<id>/snapshot
-        QString alertId = path.mid(8, path.length() - 8 - 9);  // Remove "/alerts/" and "/snapshot"
-        handleGetAlertSnapshot(socket, alertId);
+        QString alertId = url.path().mid(8, url.path().length() - 8 - 9);  // Remove "/alerts/" and "/snapshot"
+        handleGetAlertSnapshot(socket, alertId, query);
+    }
+    else if (url.path() == "/mosaic") {
+        handleGetMosaic(socket, query);
+    }
+    else if (path == "/metrics") {
+        handleGetMetrics(socket);
     }
     else if (path == "/cameras") {
         handleGetCameras(socket);
     }
-    else if (path.startsWith("/cameras/") && path.endsWith("/snapshot")) {
+    else if (url.path().startsWith("/cameras/") && url.path().endsWith("/snapshot")) {
         // Extract camera ID: /cameras/<id>/snapshot
-        QString cameraId = path.mid(9, path.length() - 9 - 9);  // Remove "/cameras/" and "/snapshot"
-        handleGetCameraSnapshot(socket, cameraId);
+        QString cameraId = url.path().mid(9, url.path().length() - 9 - 9);  // Remove "/cameras/" and "/snapshot"
+        handleGetCameraSnapshot(socket, cameraId, query);
+    }
+    else if (url.path().startsWith("/cameras/") && url.path().endsWith("/stream")) {
+        // Extract camera ID: /cameras/<id>/stream
+        QString cameraId = url.path().mid(9, url.path().length() - 9 - 7);  // Remove "/cameras/" and "/stream"
+        handleGetCameraStream(socket, cameraId, query);
     }
     else {
         sendNotFound(socket);
-        socket->disconnectFromHost();
+        finishResponse(socket);
     }
 }
 
 void HttpServer::handlePing(QTcpSocket *socket)
 {
     sendResponse(socket, 200, "OK", "text/plain", "ok");
-    socket->disconnectFromHost();
+    finishResponse(socket);
 }
 
-void HttpServer::handleGetAlerts(QTcpSocket *socket)
+void HttpServer::handleGetAlerts(QTcpSocket *socket, const HttpRequest &request,
+                                 const QUrlQuery &query)
 {
     if (!m_alertLogModel) {
         sendError(socket, 503, "Alert service not available");
-        socket->disconnectFromHost();
+        finishResponse(socket);
         return;
     }
     
-    QJsonArray alertsArray;
+    // Taken before the query runs, from the revision of the very rows the
+    // query reads. If they change meanwhile, the tag is older than the page
+    // and the next poll simply fetches it again; a tag is never newer than
+    // its page.
+    const QByteArray etag = alertsETag();
+    if (etagMatches(request.header("if-none-match"), etag)) {
+        Response response;
+        response.statusCode = 304;
+        response.statusText = "Not Modified";
+        response.headers.append({ "ETag", etag });
+        response.headers.append({ "Cache-Control", "no-cache" });
+        sendResponse(socket, response);
+        finishResponse(socket);
+        return;
+    }
     
-    int count = m_alertLogModel->rowCount();
+    // Filters: ?since=<ISO date>&until=<ISO date>&camera=<name>&type=<type>&limit=<n>&cursor=<c>
+    AlertQuery filter;
+    filter.since = QDateTime::fromString(query.queryItemValue("since"), Qt::ISODate);
+    filter.until = QDateTime::fromString(query.queryItemValue("until"), Qt::ISODate);
+    filter.cameraName = query.queryItemValue("camera", QUrl::FullyDecoded);
+    filter.type = query.queryItemValue("type");
     
-    // Return alerts in reverse order (newest first)
-    for (int i = count - 1; i >= 0; --i) {
-        QModelIndex index = m_alertLogModel->index(i, 0);
+    bool ok;
+    int limit = query.queryItemValue("limit").toInt(&ok);
+    filter.limit = ok ? qBound(1, limit, MAX_ALERTS_PER_REQUEST) : DEFAULT_ALERTS_PER_REQUEST;
+    
+    // The cursor is the sequence number of the last alert on the previous
+    // page; pages stay stable while new alerts arrive
+    if (query.hasQueryItem("cursor")) {
+        filter.beforeSeq = query.queryItemValue("cursor").toLongLong(&ok);
+        if (!ok || filter.beforeSeq < 0) {
+            sendError(socket, 400, "Invalid cursor");
+            finishResponse(socket);
+            return;
+        }
+    }
+    
+    AlertLogModel *model = m_alertLogModel;
+    respondFromWorker(socket, [model, filter, query, etag]() {
+        // Answered from the indexed history database, one page at a time
+        QVector<Alert> alerts = model->queryAlerts(filter);
         
-        QJsonObject alertObj;
-        alertObj["id"] = m_alertLogModel->data(index, AlertLogModel::IdRole).toString();
-        alertObj["timestamp"] = m_alertLogModel->data(index, AlertLogModel::TimestampRole)
-                                    .toDateTime().toString("yyyy-MM-dd HH:mm:ss");
-        alertObj["cameraName"] = m_alertLogModel->data(index, AlertLogModel::CameraNameRole).toString();
-        alertObj["type"] = m_alertLogModel->data(index, AlertLogModel::TypeRole).toString();
-        alertObj["message"] = m_alertLogModel->data(index, AlertLogModel::MessageRole).toString();
-        alertObj["hasSnapshot"] = m_alertLogModel->data(index, AlertLogModel::HasImageRole).toBool();
+        QJsonArray alertsArray;
         
-        QString snapshotPath = m_alertLogModel->data(index, AlertLogModel::SnapshotPathRole).toString();
-        if (!snapshotPath.isEmpty()) {
-            alertObj["snapshotPath"] = snapshotPath;
+        // Alerts come back newest first
+        for (const Alert &alert : alerts) {
+            alertsArray.append(alertToJson(alert));
         }
         
-        alertsArray.append(alertObj);
+        QJsonDocument doc(alertsArray);
+        Response response = jsonResponse(200, doc.toJson(QJsonDocument::Compact));
+        response.headers.append({ "ETag", etag });
+        response.headers.append({ "Cache-Control", "no-cache" });
+        
+        // A full page may have more behind it
+        if (alerts.count() == filter.limit) {
+            const QByteArray cursor = QByteArray::number(alerts.last().seq);
+            
+            QUrlQuery next(query);
+            next.removeAllQueryItems("cursor");
+            next.addQueryItem("cursor", QString::fromLatin1(cursor));
+            
+            response.headers.append({ "X-Next-Cursor", cursor });
+            response.headers.append({ "Link", "</alerts?" + next.query(QUrl::FullyEncoded).toUtf8() +
+                                              ">; rel=\"next\"" });
+        }
+        
+        return response;
+    });
+}
+
+QByteArray HttpServer::alertsETag() const
+{
+    return '"' + QByteArray::number(m_etagEpoch, 36) + '-' +
+           QByteArray::number(m_alertLogModel->queryRevision()) + '"';
+}
+
+bool HttpServer::etagMatches(const QString &ifNoneMatch, const QByteArray &etag)
+{
+    if (ifNoneMatch.isEmpty()) {
+        return false;
     }
     
-    QJsonDocument doc(alertsArray);
-    sendJsonResponse(socket, 200, doc.toJson(QJsonDocument::Compact));
-    socket->disconnectFromHost();
+    // A list of tags; weak comparison is enough for a GET
+    const QStringList candidates = ifNoneMatch.split(',');
+    for (QString candidate : candidates) {
+        candidate = candidate.trimmed();
+        if (candidate == "*") {
+            return true;
+        }
+        if (candidate.startsWith("W/")) {
+            candidate = candidate.mid(2);
+        }
+        if (candidate.toLatin1() == etag) {
+            return true;
+        }
+    }
+    
+    return false;
 }
 
-void HttpServer::handleGetAlertSnapshot(QTcpSocket *socket, const QString &alertId)
+void HttpServer::handleGetAlertSnapshot(QTcpSocket *socket, const QString &alertId,
+                                        const QUrlQuery &query)
 {
     if (!m_alertLogModel) {
         sendError(socket, 503, "Alert service not available");
-        socket->disconnectFromHost();
+        finishResponse(socket);
         return;
     }
     
-    // Find alert by ID
-    int count = m_alertLogModel->rowCount();
-    QImage snapshotImage;
-    QString snapshotPath;
-    bool found = false;
+    // ?size=full (default) or ?size=thumb
+    const QString size = query.queryItemValue("size");
+    if (!size.isEmpty() && size != "full" && size != "thumb") {
+        sendError(socket, 400, "Invalid size");
+        finishResponse(socket);
+        return;
+    }
+    const bool thumbnail = (size == "thumb");
     
-    for (int i = 0; i < count; ++i) {
-        QModelIndex index = m_alertLogModel->index(i, 0);
-        QString id = m_alertLogModel->data(index, AlertLogModel::IdRole).toString();
+    AlertLogModel *model = m_alertLogModel;
+    respondFromWorker(socket, [this, model, alertId, thumbnail]() {
+        // Lookup in the rows in memory, falling back to the history for evicted alerts
+        Alert alert;
+        if (!model->findAlert(alertId, &alert)) {
+            return notFoundResponse("Alert not found");
+        }
         
-        if (id == alertId) {
-            found = true;
-            
-            // Check if there's an in-memory image
-            bool hasImage = m_alertLogModel->data(index, AlertLogModel::HasImageRole).toBool();
-            if (hasImage) {
-                // Get the image directly from the model
-                // We need to access the internal Alert structure
-                // For now, try to get from snapshot path first
-                snapshotPath = m_alertLogModel->data(index, AlertLogModel::SnapshotPathRole).toString();
-            } else {
-                snapshotPath = m_alertLogModel->data(index, AlertLogModel::SnapshotPathRole).toString();
+        Response response;
+        response.contentType = "image/jpeg";
+        // A snapshot never changes once taken
+        response.headers.append({ "Cache-Control", "private, max-age=86400" });
+        
+        const QString snapshotPath = alert.snapshotPath;
+        
+        // Saved snapshots are served as they are on disk
+        if (!thumbnail && !snapshotPath.isEmpty() && QFile::exists(snapshotPath)) {
+            QFile file(snapshotPath);
+            if (file.open(QIODevice::ReadOnly)) {
+                response.body = file.readAll();
+                if (!snapshotPath.endsWith(".jpg") && !snapshotPath.endsWith(".jpeg")) {
+                    response.contentType = "image/png";
+                }
+                return response;
             }
-            break;
         }
-    }
-    
-    if (!found) {
-        sendNotFound(socket, "Alert not found");
-        socket->disconnectFromHost();
-        return;
-    }
-    
-    // Try to load from file path if available
-    if (!snapshotPath.isEmpty() && QFile::exists(snapshotPath)) {
-        QFile file(snapshotPath);
-        if (file.open(QIODevice::ReadOnly)) {
-            QByteArray imageData = file.readAll();
-            file.close();
-            
-            QString mimeType = "image/png";
-            if (snapshotPath.endsWith(".jpg") || snapshotPath.endsWith(".jpeg")) {
-                mimeType = "image/jpeg";
+        
+        // In-memory snapshots, encoded at most once per alert and size
+        const QString cacheKey = alertId + (thumbnail ? "/thumb" : "/full");
+        {
+            QMutexLocker locker(&m_snapshotCacheMutex);
+            if (const QByteArray *cached = m_snapshotCache.object(cacheKey)) {
+                response.body = *cached;
+                return response;
             }
-            
-            sendImageResponse(socket, imageData, mimeType);
-            socket->disconnectFromHost();
-            return;
         }
-    }
-    
-    // If we have an in-memory image, we need a way to get it
-    // For now, return 404 if file doesn't exist
-    sendNotFound(socket, "Snapshot not available");
-    socket->disconnectFromHost();
+        
+        response.body = model->snapshotJpeg(alert, thumbnail);
+        if (response.body.isEmpty()) {
+            return notFoundResponse("Snapshot not available");
+        }
+        
+        {
+            QMutexLocker locker(&m_snapshotCacheMutex);
+            m_snapshotCache.insert(cacheKey, new QByteArray(response.body),
+                                   qMax<qsizetype>(1, response.body.size() / 1024));
+        }
+        return response;
+    });
 }
 
 void HttpServer::handleGetCameras(QTcpSocket *socket)
 {
     if (!m_cameraManager) {
         sendError(socket, 503, "Camera service not available");
-        socket->disconnectFromHost();
+        finishResponse(socket);
         return;
     }
     
     QJsonArray camerasArray;
     
-    // Check all 4 camera slots
-    for (int i = 1; i <= 4; ++i) {
-        if (m_cameraManager->cameraAvailable(i)) {
-            QJsonObject camObj;
-            
-            // Generate camera ID (cam0, cam1, cam2, cam3)
-            camObj["id"] = QString("cam%1").arg(i - 1);
-            camObj["name"] = m_cameraManager->cameraName(i);
-            camObj["type"] = m_cameraManager->cameraType(i);
-            camObj["source"] = m_cameraManager->cameraSource(i);
-            
-            camerasArray.append(camObj);
-        }
+    // One entry per enabled camera, identified by its configured ID
+    for (const CameraInfo &camera : m_cameraManager->cameraInfos()) {
+        QJsonObject camObj;
+        
+        camObj["id"] = camera.id;
+        camObj["name"] = camera.name;
+        camObj["type"] = camera.type;
+        camObj["source"] = camera.source;
+        
+        camerasArray.append(camObj);
     }
     
     QJsonDocument doc(camerasArray);
     sendJsonResponse(socket, 200, doc.toJson(QJsonDocument::Compact));
-    socket->disconnectFromHost();
+    finishResponse(socket);
 }
 
-void HttpServer::handleGetCameraSnapshot(QTcpSocket *socket, const QString &cameraId)
+void HttpServer::handleGetCameraSnapshot(QTcpSocket *socket, const QString &cameraId,
+                                         const QUrlQuery &query)
 {
     if (!m_cameraManager) {
         sendError(socket, 503, "Camera service not available");
-        socket->disconnectFromHost();
+        finishResponse(socket);
         return;
     }
     
-    // Parse camera ID (cam0, cam1, cam2, cam3)
-    if (!cameraId.startsWith("cam")) {
-        sendNotFound(socket, "Invalid camera ID");
-        socket->disconnectFromHost();
+    CameraStream *stream = findCamera(cameraId);
+    if (!stream) {
+        sendNotFound(socket, "Camera stream not available");
+        finishResponse(socket);
         return;
     }
     
+    // ?quality=<1-100>. Encoded off this thread, once per frame and quality,
+    // so polling dashboards are mostly served straight from the cache.
     bool ok;
-    int cameraIndex = cameraId.mid(3).toInt(&ok);
-    if (!ok || cameraIndex < 0 || cameraIndex > 3) {
-        sendNotFound(socket, "Invalid camera ID");
-        socket->disconnectFromHost();
+    int quality = query.queryItemValue("quality").toInt(&ok);
+    quality = ok ? qBound(1, quality, 100) : DEFAULT_SNAPSHOT_QUALITY;
+    
+    // The client may disconnect before the encode finishes
+    QPointer<QTcpSocket> guard(socket);
+    m_frameCache->requestFrame(stream, quality, [this, guard](const EncodedFrame &frame) {
+        if (!guard) {
+            return;
+        }
+        
+        if (frame.jpeg.isEmpty()) {
+            if (frame.sequence == 0) {
+                sendError(guard, 503, "No frame available");
+            } else {
+                sendError(guard, 500, "Failed to encode image");
+            }
+        } else {
+            sendImageResponse(guard, frame.jpeg, "image/jpeg");
+        }
+        finishResponse(guard);
+    });
+}
+
+void HttpServer::handleGetCameraStream(QTcpSocket *socket, const QString &cameraId,
+                                       const QUrlQuery &query)
+{
+    if (!m_cameraManager) {
+        sendError(socket, 503, "Camera service not available");
+        finishResponse(socket);
         return;
     }
     
-    // Convert to 1-based index for CameraManager
-    int managerIndex = cameraIndex + 1;
+    CameraStream *stream = findCamera(cameraId);
+    if (!stream) {
+        sendNotFound(socket, "Camera stream not available");
+        finishResponse(socket);
+        return;
+    }
     
-    if (!m_cameraManager->cameraAvailable(managerIndex)) {
-        sendNotFound(socket, "Camera not available");
-        socket->disconnectFromHost();
+    // ?quality=<1-100>; clients asking for the same quality share each encode
+    bool ok;
+    int quality = query.queryItemValue("quality").toInt(&ok);
+    quality = ok ? qBound(1, quality, 100) : DEFAULT_STREAM_QUALITY;
+    
+    beginMultipartStream(socket);
+    
+    StreamClient client;
+    client.cameraId = stream->id();
+    client.quality = quality;
+    client.lastSequence = 0;
+    client.waiting = false;
+    m_streamClients.insert(socket, client);
+    
+    // One frameChanged connection per camera, however many viewers it has
+    if (!m_streamFeeds.contains(client.cameraId)) {
+        m_streamFeeds.insert(client.cameraId,
+            connect(stream, &CameraStream::frameChanged, this, [this, stream]() {
+                onStreamedFrameChanged(stream);
+            }));
+    }
+    
+    qDebug() << "MJPEG stream started for camera" << client.cameraId
+             << "- viewers:" << m_streamClients.count();
+    
+    // Start with the current frame rather than waiting for the next one
+    onStreamedFrameChanged(stream);
+}
+
+void HttpServer::handleGetMosaic(QTcpSocket *socket, const QUrlQuery &query)
+{
+    if (!m_cameraManager) {
+        sendError(socket, 503, "Camera service not available");
+        finishResponse(socket);
         return;
     }
     
-    // Get camera stream
-    CameraStream *stream = nullptr;
-    switch(managerIndex) {
-        case 1: stream = qobject_cast<CameraStream*>(m_cameraManager->camera1()); break;
-        case 2: stream = qobject_cast<CameraStream*>(m_cameraManager->camera2()); break;
-        case 3: stream = qobject_cast<CameraStream*>(m_cameraManager->camera3()); break;
-        case 4: stream = qobject_cast<CameraStream*>(m_cameraManager->camera4()); break;
+    // ?cameras=<id>,<id>,... (default: all), in grid order
+    QStringList cameraIds = query.queryItemValue("cameras", QUrl::FullyDecoded)
+                                .split(',', Qt::SkipEmptyParts);
+    if (cameraIds.isEmpty()) {
+        for (const CameraInfo &info : m_cameraManager->cameraInfos()) {
+            cameraIds.append(info.id);
+        }
+    }
+    if (cameraIds.isEmpty() || cameraIds.count() > MAX_MOSAIC_CAMERAS) {
+        sendError(socket, 400, "Invalid camera set");
+        finishResponse(socket);
+        return;
     }
     
-    if (!stream) {
-        sendNotFound(socket, "Camera stream not available");
-        socket->disconnectFromHost();
+    QVector<CameraStream*> cameras;
+    for (QString &cameraId : cameraIds) {
+        CameraStream *stream = findCamera(cameraId.trimmed());
+        if (!stream) {
+            sendNotFound(socket, "Camera stream not available: " + cameraId);
+            finishResponse(socket);
+            return;
+        }
+        cameraId = stream->id();
+        cameras.append(stream);
+    }
+    
+    // ?width=&height=&fps=&quality=
+    auto intParam = [&query](const char *name, int fallback, int min, int max) {
+        bool ok;
+        const int value = query.queryItemValue(name).toInt(&ok);
+        return ok ? qBound(min, value, max) : fallback;
+    };
+    const QSize size(intParam("width", DEFAULT_MOSAIC_WIDTH, 160, MAX_MOSAIC_WIDTH),
+                     intParam("height", DEFAULT_MOSAIC_HEIGHT, 90, MAX_MOSAIC_HEIGHT));
+    const int fps = intParam("fps", DEFAULT_MOSAIC_FPS, 1, MAX_MOSAIC_FPS);
+    const int quality = intParam("quality", DEFAULT_STREAM_QUALITY, 1, 100);
+    
+    // Viewers asking for the same mosaic share one composer
+    const QString key = QString("mosaic/%1/%2x%3/%4/%5")
+                            .arg(cameraIds.join(','))
+                            .arg(size.width()).arg(size.height())
+                            .arg(fps).arg(quality);
+    
+    beginMultipartStream(socket);
+    
+    StreamClient client;
+    client.cameraId = key;
+    client.quality = quality;
+    client.lastSequence = 0;
+    client.waiting = false;
+    m_streamClients.insert(socket, client);
+    
+    MosaicComposer *mosaic = m_mosaics.value(key);
+    if (!mosaic) {
+        mosaic = new MosaicComposer(key, cameras, size, fps, quality, this);
+        mosaic->setViewerReadyCheck([this, key]() {
+            return hasReadyStreamClient(key);
+        });
+        m_mosaics.insert(key, mosaic);
+        m_streamFeeds.insert(key, connect(mosaic, &MosaicComposer::frameReady,
+                                          this, &HttpServer::sendStreamFrame));
+        mosaic->start();
+    }
+    
+    qDebug() << "Mosaic stream started:" << key << "- viewers:" << m_streamClients.count();
+    
+    // Start with the current composite rather than waiting for the next one
+    sendStreamFrame(mosaic->lastFrame());
+}
+
+void HttpServer::beginMultipartStream(QTcpSocket *socket)
+{
+    QByteArray response;
+    response.append("HTTP/1.1 200 OK\r\n");
+    response.append("Content-Type: multipart/x-mixed-replace; boundary=frame\r\n");
+    response.append("Cache-Control: no-cache\r\n");
+    response.append("Connection: close\r\n");
+    response.append("Access-Control-Allow-Origin: *\r\n");
+    response.append("\r\n");
+    socket->write(response);
+    
+    // The connection now belongs to the stream; anything pipelined behind it is dropped
+    auto connection = m_connections.find(socket);
+    if (connection != m_connections.end()) {
+        connection->closeAfterResponse = true;
+        connection->buffer.clear();
+    }
+}
+
+void HttpServer::handleGetMetrics(QTcpSocket *socket)
+{
+    // Everything read here is an atomic or lives on this thread, so a scrape
+    // never waits on the pipeline
+    QVector<QPair<QString, CameraStream*>> cameras;
+    if (m_cameraManager) {
+        for (const CameraInfo &info : m_cameraManager->cameraInfos()) {
+            if (CameraStream *stream = m_cameraManager->cameraById(info.id)) {
+                cameras.append({ info.id, stream });
+            }
+        }
+    }
+    
+    PrometheusWriter out;
+    
+    // Capture
+    out.family("surveillance_camera_capture_fps", "gauge", "Frames per second read from the camera.");
+    for (const auto &camera : cameras) {
+        out.sample("surveillance_camera_capture_fps",
+                   camera.second->metrics().captureFps.load(std::memory_order_relaxed),
+                   { { "camera", camera.first } });
+    }
+    out.family("surveillance_camera_frames_captured_total", "counter", "Frames read from the camera.");
+    for (const auto &camera : cameras) {
+        out.sample("surveillance_camera_frames_captured_total",
+                   camera.second->metrics().framesCaptured.load(std::memory_order_relaxed),
+                   { { "camera", camera.first } });
+    }
+    out.family("surveillance_camera_dropped_frames_total", "counter",
+               "Frames skipped because a later stage was behind.");
+    for (const auto &camera : cameras) {
+        out.sample("surveillance_camera_dropped_frames_total", camera.second->droppedDisplayFrames(),
+                   { { "camera", camera.first }, { "stage", "display" } });
+        out.sample("surveillance_camera_dropped_frames_total", camera.second->droppedAnalysisFrames(),
+                   { { "camera", camera.first }, { "stage", "analysis" } });
+        out.sample("surveillance_camera_dropped_frames_total", camera.second->droppedClipFrames(),
+                   { { "camera", camera.first }, { "stage", "clip" } });
+    }
+    
+    // Per-stage timings
+    out.family("surveillance_camera_decode_seconds", "histogram",
+               "Time to read and decode a frame, including waiting for the source.");
+    for (const auto &camera : cameras) {
+        out.histogram("surveillance_camera_decode_seconds", camera.second->metrics().decode,
+                      { { "camera", camera.first } });
+    }
+    out.family("surveillance_camera_motion_seconds", "histogram", "Motion, ROI and tripwire analysis time per frame.");
+    for (const auto &camera : cameras) {
+        out.histogram("surveillance_camera_motion_seconds", camera.second->metrics().motion,
+                      { { "camera", camera.first } });
+    }
+    out.family("surveillance_camera_inference_seconds", "histogram",
+               "Object detection time per analyzed frame, including waiting for the shared network.");
+    for (const auto &camera : cameras) {
+        out.histogram("surveillance_camera_inference_seconds", camera.second->metrics().inference,
+                      { { "camera", camera.first } });
+    }
+    out.family("surveillance_camera_postprocess_seconds", "histogram",
+               "Tracking, line crossing and loitering time per analyzed frame.");
+    for (const auto &camera : cameras) {
+        out.histogram("surveillance_camera_postprocess_seconds", camera.second->metrics().postProcess,
+                      { { "camera", camera.first } });
+    }
+    
+    // Queues and tracking
+    out.family("surveillance_camera_analysis_backlog", "gauge", "Frames queued or running on the camera's analysis strand.");
+    for (const auto &camera : cameras) {
+        out.sample("surveillance_camera_analysis_backlog", camera.second->analysisBacklog(),
+                   { { "camera", camera.first } });
+    }
+    out.family("surveillance_camera_active_tracks", "gauge", "Objects currently tracked.");
+    for (const auto &camera : cameras) {
+        out.sample("surveillance_camera_active_tracks",
+                   camera.second->metrics().activeTracks.load(std::memory_order_relaxed),
+                   { { "camera", camera.first } });
+    }
+    const ObjectDetector *detector = m_cameraManager ? m_cameraManager->detector() : nullptr;
+    out.family("surveillance_detector_queued_inferences", "gauge", "Cameras waiting for the shared detector network.");
+    out.sample("surveillance_detector_queued_inferences", detector ? detector->queuedInferences() : 0);
+    
+    // Alerts
+    out.family("surveillance_alerts_total", "counter", "Alerts raised since the server started.");
+    for (auto it = m_alertsByType.cbegin(); it != m_alertsByType.cend(); ++it) {
+        out.sample("surveillance_alerts_total", it.value(), { { "type", it.key() } });
+    }
+    if (m_alertLogModel) {
+        out.family("surveillance_alert_log_rows", "gauge", "Alerts held in memory.");
+        out.sample("surveillance_alert_log_rows", m_alertLogModel->alertsSnapshot().count());
+        out.family("surveillance_alert_log_snapshot_bytes", "gauge", "Memory used by alert snapshots.");
+        out.sample("surveillance_alert_log_snapshot_bytes", m_alertLogModel->publishedSnapshotBytes());
+    }
+    
+    // HTTP
+    out.family("surveillance_http_responses_total", "counter", "Responses sent, by status code.");
+    for (auto it = m_responsesByStatus.cbegin(); it != m_responsesByStatus.cend(); ++it) {
+        out.sample("surveillance_http_responses_total", it.value(), { { "code", QString::number(it.key()) } });
+    }
+    out.family("surveillance_http_request_duration_seconds", "histogram",
+               "Time from receiving a request to finishing its response; streams excluded.");
+    out.histogram("surveillance_http_request_duration_seconds", m_requestLatency);
+    out.family("surveillance_http_connections", "gauge", "Open client connections.");
+    out.sample("surveillance_http_connections", m_connections.count());
+    out.family("surveillance_http_rejected_connections_total", "counter",
+               "Connections refused with 503, by reason.");
+    for (auto it = m_rejectedConnections.cbegin(); it != m_rejectedConnections.cend(); ++it) {
+        out.sample("surveillance_http_rejected_connections_total", it.value(), { { "reason", it.key() } });
+    }
+    out.family("surveillance_http_stream_clients", "gauge", "Connections held open by a stream.");
+    out.sample("surveillance_http_stream_clients", m_streamClients.count(), { { "stream", "mjpeg" } });
+    out.sample("surveillance_http_stream_clients", m_eventClients.count(), { { "stream", "alerts" } });
+    
+    sendResponse(socket, 200, "OK", "text/plain; version=0.0.4; charset=utf-8", out.data());
+    finishResponse(socket);
+}
+
+CameraStream *HttpServer::findCamera(const QString &cameraId) const
+{
+    // Look up by configured camera ID
+    CameraStream *stream = m_cameraManager->cameraById(cameraId);
+    
+    // Fall back to the legacy zero-based "cam<N>" slot form (cam0 = first camera)
+    if (!stream && cameraId.startsWith("cam")) {
+        bool ok;
+        int cameraIndex = cameraId.mid(3).toInt(&ok);
+        if (ok && cameraIndex >= 0) {
+            stream = qobject_cast<CameraStream*>(m_cameraManager->camera(cameraIndex + 1));
+        }
+    }
+    
+    return stream;
+}
+
+void HttpServer::onStreamedFrameChanged(CameraStream *stream)
+{
+    // One request per quality in use; every viewer of that quality gets the
+    // result. Qualities whose viewers are all behind are not encoded at all.
+    QVector<int> qualities;
+    for (auto it = m_streamClients.begin(); it != m_streamClients.end(); ++it) {
+        StreamClient &client = it.value();
+        if (client.cameraId != stream->id()) {
+            continue;
+        }
+        if (it.key()->bytesToWrite() > 0) {
+            client.waiting = true;
+            continue;
+        }
+        if (!qualities.contains(client.quality)) {
+            qualities.append(client.quality);
+        }
+    }
+    
+    for (int quality : qualities) {
+        m_frameCache->requestFrame(stream, quality, [this](const EncodedFrame &frame) {
+            sendStreamFrame(frame);
+        });
+    }
+}
+
+void HttpServer::sendStreamFrame(const EncodedFrame &frame)
+{
+    if (frame.jpeg.isEmpty()) {
         return;
     }
     
-    // Get current frame
-    QImage frame = stream->frame();
+    const QByteArray partHeader = QString("--frame\r\n"
+                                          "Content-Type: image/jpeg\r\n"
+                                          "Content-Length: %1\r\n"
+                                          "\r\n").arg(frame.jpeg.size()).toUtf8();
     
-    if (frame.isNull()) {
-        sendError(socket, 503, "No frame available");
-        socket->disconnectFromHost();
+    for (auto it = m_streamClients.begin(); it != m_streamClients.end(); ++it) {
+        StreamClient &client = it.value();
+        if (client.cameraId != frame.cameraId || client.quality != frame.quality ||
+            client.lastSequence == frame.sequence) {
+            continue;
+        }
+        
+        // A client still holding the previous frame skips this one
+        // instead of queueing it
+        QTcpSocket *socket = it.key();
+        if (socket->bytesToWrite() > 0) {
+            client.waiting = true;
+            continue;
+        }
+        
+        client.lastSequence = frame.sequence;
+        socket->write(partHeader);
+        socket->write(frame.jpeg);
+        socket->write("\r\n");
+    }
+}
+
+void HttpServer::removeStreamClient(QTcpSocket *socket)
+{
+    auto it = m_streamClients.find(socket);
+    if (it == m_streamClients.end()) {
         return;
     }
     
-    // Convert QImage to JPEG
-    QByteArray imageData;
-    QBuffer buffer(&imageData);
-    buffer.open(QIODevice::WriteOnly);
+    const QString cameraId = it->cameraId;
+    m_streamClients.erase(it);
     
-    if (!frame.save(&buffer, "JPEG", 85)) {  // 85% quality
-        sendError(socket, 500, "Failed to encode image");
-        socket->disconnectFromHost();
+    // Stop following the camera once its last viewer is gone
+    for (const StreamClient &client : std::as_const(m_streamClients)) {
+        if (client.cameraId == cameraId) {
+            return;
+        }
+    }
+    disconnect(m_streamFeeds.take(cameraId));
+    
+    // A mosaic only runs while someone watches it
+    if (MosaicComposer *mosaic = m_mosaics.take(cameraId)) {
+        mosaic->deleteLater();
+        qDebug() << "Mosaic stream stopped:" << cameraId;
         return;
     }
     
-    sendImageResponse(socket, imageData, "image/jpeg");
-    socket->disconnectFromHost();
+    qDebug() << "MJPEG stream stopped for camera" << cameraId;
 }
 
-void HttpServer::sendResponse(QTcpSocket *socket, int statusCode, const QString &statusText,
-                              const QString &contentType, const QByteArray &body)
+bool HttpServer::hasReadyStreamClient(const QString &cameraId) const
+{
+    for (auto it = m_streamClients.cbegin(); it != m_streamClients.cend(); ++it) {
+        if (it->cameraId == cameraId && it.key()->bytesToWrite() == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HttpServer::catchUpStreamClient(QTcpSocket *socket)
+{
+    const StreamClient client = m_streamClients.value(socket);
+    
+    // Mosaics keep their last composite; camera frames come from the cache,
+    // usually without a new encode
+    if (MosaicComposer *mosaic = m_mosaics.value(client.cameraId)) {
+        sendStreamFrame(mosaic->lastFrame());
+        return;
+    }
+    
+    CameraStream *stream = findCamera(client.cameraId);
+    if (!stream) {
+        return;
+    }
+    m_frameCache->requestFrame(stream, client.quality, [this](const EncodedFrame &frame) {
+        sendStreamFrame(frame);
+    });
+}
+
+void HttpServer::handleGetAlertStream(QTcpSocket *socket, const HttpRequest &request,
+                                      const QUrlQuery &query)
 {
+    if (!m_alertLogModel) {
+        sendError(socket, 503, "Alert service not available");
+        finishResponse(socket);
+        return;
+    }
+    
+    // Resume point: Last-Event-ID as sent by EventSource when it reconnects,
+    // or ?lastEventId= for clients that cannot set headers
+    QString lastEventId = request.header("last-event-id");
+    if (lastEventId.isEmpty()) {
+        lastEventId = query.queryItemValue("lastEventId");
+    }
+    bool resume;
+    const qint64 lastSeq = lastEventId.toLongLong(&resume);
+    resume = resume && lastSeq >= 0;
+    
     QByteArray response;
-    response.append(QString("HTTP/1.1 %1 %2\r\n").arg(statusCode).arg(statusText).toUtf8());
-    response.append(QString("Content-Type: %1\r\n").arg(contentType).toUtf8());
-    response.append(QString("Content-Length: %1\r\n").arg(body.size()).toUtf8());
+    response.append("HTTP/1.1 200 OK\r\n");
+    response.append("Content-Type: text/event-stream\r\n");
+    response.append("Cache-Control: no-cache\r\n");
     response.append("Connection: close\r\n");
-    response.append("Access-Control-Allow-Origin: *\r\n");  // Enable CORS
+    response.append("Access-Control-Allow-Origin: *\r\n");
     response.append("\r\n");
-    response.append(body);
-    
+    response.append(QString("retry: %1\n\n").arg(EVENT_RETRY_MS).toUtf8());
     socket->write(response);
-    socket->flush();
+    
+    // The connection now belongs to the stream
+    auto connection = m_connections.find(socket);
+    if (connection != m_connections.end()) {
+        connection->closeAfterResponse = true;
+        connection->buffer.clear();
+    }
+    
+    EventClient client;
+    client.lastSeq = resume ? lastSeq : m_lastAlertSeq;
+    client.replaying = false;
+    m_eventClients.insert(socket, client);
+    
+    qDebug() << "Alert stream opened - subscribers:" << m_eventClients.count()
+             << (resume ? QString("resuming after %1").arg(lastSeq) : QString());
+    
+    if (!resume) {
+        return;
+    }
+    
+    // Gone only briefly: everything missed is still in the recent events
+    if (!m_recentAlertEvents.empty() && lastSeq >= m_recentAlertEvents.front().seq - 1) {
+        sendRecentAlertEvents(socket);
+        return;
+    }
+    
+    m_eventClients[socket].replaying = true;
+    replayAlertsFromStore(socket, lastSeq);
 }
 
-void HttpServer::sendJsonResponse(QTcpSocket *socket, int statusCode, const QByteArray &json)
+void HttpServer::replayAlertsFromStore(QTcpSocket *socket, qint64 afterSeq)
 {
-    QString statusText = (statusCode == 200) ? "OK" : "Error";
-    sendResponse(socket, statusCode, statusText, "application/json", json);
+    AlertQuery filter;
+    filter.afterSeq = afterSeq;
+    filter.oldestFirst = true;
+    filter.limit = ALERT_REPLAY_BATCH;
+    
+    AlertLogModel *model = m_alertLogModel;
+    QPointer<QTcpSocket> guard(socket);
+    m_workerPool.start([this, guard, model, filter]() {
+        const QVector<Alert> alerts = model->queryAlerts(filter);
+        
+        QVector<AlertEvent> events;
+        events.reserve(alerts.count());
+        for (const Alert &alert : alerts) {
+            events.append({ alert.seq, alertEvent(alert) });
+        }
+        const bool more = alerts.count() == filter.limit;
+        
+        QMetaObject::invokeMethod(this, [this, guard, events, more]() {
+            if (!guard) {
+                return;
+            }
+            auto it = m_eventClients.find(guard);
+            if (it == m_eventClients.end()) {
+                return;
+            }
+            
+            for (const AlertEvent &event : events) {
+                if (event.seq > it->lastSeq) {
+                    guard->write(event.data);
+                    it->lastSeq = event.seq;
+                }
+            }
+            
+            // A full batch: there may be more history before the live events
+            if (more) {
+                replayAlertsFromStore(guard, it->lastSeq);
+                return;
+            }
+            
+            it->replaying = false;
+            sendRecentAlertEvents(guard);
+        }, Qt::QueuedConnection);
+    });
 }
 
-void HttpServer::sendImageResponse(QTcpSocket *socket, const QByteArray &imageData, 
-                                  const QString &mimeType)
+void HttpServer::sendRecentAlertEvents(QTcpSocket *socket)
 {
-    sendResponse(socket, 200, "OK", mimeType, imageData);
+    auto it = m_eventClients.find(socket);
+    if (it == m_eventClients.end()) {
+        return;
+    }
+    
+    for (const AlertEvent &event : m_recentAlertEvents) {
+        if (event.seq > it->lastSeq) {
+            socket->write(event.data);
+            it->lastSeq = event.seq;
+        }
+    }
 }
 
-void HttpServer::sendNotFound(QTcpSocket *socket, const QString &message)
+void HttpServer::onAlertAdded(const Alert &alert)
+{
+    // Serialized once, whatever the number of subscribers
+    AlertEvent event{ alert.seq, alertEvent(alert) };
+    
+    m_recentAlertEvents.push_back(event);
+    while (m_recentAlertEvents.size() > MAX_RECENT_ALERT_EVENTS) {
+        m_recentAlertEvents.pop_front();
+    }
+    m_lastAlertSeq = qMax(m_lastAlertSeq, alert.seq);
+    m_alertsByType[alert.type]++;
+    
+    QVector<QTcpSocket*> stalled;
+    for (auto it = m_eventClients.begin(); it != m_eventClients.end(); ++it) {
+        EventClient &client = it.value();
+        if (client.replaying || event.seq <= client.lastSeq) {
+            continue;
+        }
+        
+        // A client that stopped reading can resume with Last-Event-ID later
+        QTcpSocket *socket = it.key();
+        if (socket->bytesToWrite() > MAX_EVENT_BACKLOG_BYTES) {
+            stalled.append(socket);
+            continue;
+        }
+        
+        socket->write(event.data);
+        client.lastSeq = event.seq;
+    }
+    
+    // Outside the loop; abort() emits disconnected() right away
+    for (QTcpSocket *socket : stalled) {
+        qWarning() << "Dropping alert stream subscriber that is not reading:" << socket->peerAddress();
+        socket->abort();
+    }
+}
+
+void HttpServer::sendEventHeartbeats()
+{
+    // Comment lines, so proxies do not time out quiet streams
+    for (auto it = m_eventClients.cbegin(); it != m_eventClients.cend(); ++it) {
+        if (it.key()->bytesToWrite() == 0) {
+            it.key()->write(": keepalive\n\n");
+        }
+    }
+}
+
+QJsonObject HttpServer::alertToJson(const Alert &alert)
+{
+    QJsonObject alertObj;
+    alertObj["id"] = alert.id;
+    alertObj["timestamp"] = alert.timestamp.toString("yyyy-MM-dd HH:mm:ss");
+    alertObj["cameraName"] = alert.cameraName;
+    alertObj["type"] = alert.type;
+    alertObj["message"] = alert.message;
+    alertObj["hasSnapshot"] = alert.hasStoredSnapshot;
+    alertObj["repeatCount"] = alert.repeatCount;
+    if (alert.repeatCount > 1) {
+        alertObj["lastTimestamp"] = alert.lastTimestamp.toString("yyyy-MM-dd HH:mm:ss");
+    }
+    
+    if (!alert.snapshotPath.isEmpty()) {
+        alertObj["snapshotPath"] = alert.snapshotPath;
+    }
+    if (!alert.clipPath.isEmpty()) {
+        alertObj["clipPath"] = alert.clipPath;
+    }
+    
+    return alertObj;
+}
+
+QByteArray HttpServer::alertEvent(const Alert &alert)
+{
+    // Compact JSON has no newlines, so it fits in a single data field
+    QByteArray event;
+    event.append("id: " + QByteArray::number(alert.seq) + "\n");
+    event.append("event: alert\n");
+    event.append("data: " + QJsonDocument(alertToJson(alert)).toJson(QJsonDocument::Compact) + "\n");
+    event.append("\n");
+    return event;
+}
+
+void HttpServer::respondFromWorker(QTcpSocket *socket, std::function<Response()> work)
+{
+    QPointer<QTcpSocket> guard(socket);
+    m_workerPool.start([this, guard, work]() {
+        const Response response = work();
+        
+        QMetaObject::invokeMethod(this, [this, guard, response]() {
+            if (!guard) {
+                return;
+            }
+            sendResponse(guard, response);
+            finishResponse(guard);
+        }, Qt::QueuedConnection);
+    });
+}
+
+HttpServer::Response HttpServer::jsonResponse(int statusCode, const QByteArray &json)
+{
+    Response response;
+    response.statusCode = statusCode;
+    response.statusText = (statusCode == 200) ? "OK" : "Error";
+    response.contentType = "application/json";
+    response.body = json;
+    return response;
+}
+
+HttpServer::Response HttpServer::errorResponse(int statusCode, const QString &message)
 {
     QJsonObject errorObj;
     errorObj["error"] = message;
+    errorObj["statusCode"] = statusCode;
     
-    QJsonDocument doc(errorObj);
-    sendJsonResponse(socket, 404, doc.toJson(QJsonDocument::Compact));
+    Response response;
+    response.statusCode = statusCode;
+    response.statusText = message;
+    response.contentType = "application/json";
+    response.body = QJsonDocument(errorObj).toJson(QJsonDocument::Compact);
+    return response;
 }
 
-void HttpServer::sendError(QTcpSocket *socket, int statusCode, const QString &message)
+HttpServer::Response HttpServer::notFoundResponse(const QString &message)
 {
     QJsonObject errorObj;
     errorObj["error"] = message;
-    errorObj["statusCode"] = statusCode;
     
-    QJsonDocument doc(errorObj);
+    return jsonResponse(404, QJsonDocument(errorObj).toJson(QJsonDocument::Compact));
+}
+
+void HttpServer::sendResponse(QTcpSocket *socket, int statusCode, const QString &statusText,
+                              const QString &contentType, const QByteArray &body)
+{
+    Response response;
+    response.statusCode = statusCode;
+    response.statusText = statusText;
+    response.contentType = contentType;
+    response.body = body;
+    sendResponse(socket, response);
+}
+
+void HttpServer::sendResponse(QTcpSocket *socket, const Response &response)
+{
+    const QByteArray &body = response.body;
+    m_responsesByStatus[response.statusCode]++;
+    
+    QByteArray data;
+    data.append(QString("HTTP/1.1 %1 %2\r\n").arg(response.statusCode).arg(response.statusText).toUtf8());
     
-    QString statusText = message;
-    sendResponse(socket, statusCode, statusText, "application/json", 
-                doc.toJson(QJsonDocument::Compact));
-}
\ No newline at end of file
+    // A 304 has no body, and must not claim one
+    if (response.statusCode != 304) {
+        data.append(QString("Content-Type: %1\r\n").arg(response.contentType).toUtf8());
+        data.append(QString("Content-Length: %1\r\n").arg(body.size()).toUtf8());
+    }
+    for (const auto &header : response.headers) {
+        data.append(header.first + ": " + header.second + "\r\n");
+    }
+    
+    auto it = m_connections.constFind(socket);
+    if (it != m_connections.cend() && !it->closeAfterResponse) {
+        data.append(QString("Connection: keep-alive\r\n"
+                            "Keep-Alive: timeout=%1\r\n").arg(KEEP_ALIVE_TIMEOUT_MS / 1000).toUtf8());
+    } else {
+        data.append("Connection: close\r\n");
+    }
+    data.append("Access-Control-Allow-Origin: *\r\n");  // Enable CORS
+    data.append("\r\n");
+    if (response.statusCode != 304) {
+        data.append(body);
+    }
+    
+    socket->write(data);
+    socket->flush();
+}
+
+void HttpServer::sendJsonResponse(QTcpSocket *socket, int statusCode, const QByteArray &json)
+{
+    sendResponse(socket, jsonResponse(statusCode, json));
+}
+
+void HttpServer::sendImageResponse(QTcpSocket *socket, const QByteArray &imageData, 
+                                  const QString &mimeType)
+{
+    sendResponse(socket, 200, "OK", mimeType, imageData);
+}
+
+void HttpServer::sendNotFound(QTcpSocket *socket, const QString &message)
+{
+    sendResponse(socket, notFoundResponse(message));
+}
+
+void HttpServer::sendError(QTcpSocket *socket, int statusCode, const QString &message)
+{
+    sendResponse(socket, errorResponse(statusCode, message));
+}
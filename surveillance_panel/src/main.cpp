@@ -3,11 +3,13 @@
 #include <QQmlContext>
 #include <QCoreApplication>
 #include <QDir>
+#include <QThread>
 #include <iostream>
 #include "CameraStream.h"
 #include "CameraImageProvider.h"
 #include "CameraManager.h"
 #include "AlertLogModel.h"
+#include "AlertSnapshotProvider.h"
 #include "HttpServer.h"
 
 int main(int argc, char *argv[])
@@ -39,117 +41,119 @@ int main(int argc, char *argv[])
     // Logs directory
     appDir.mkpath("logs");
     QString logsDir = appDir.filePath("logs");
+    
+    // Event clips directory
+    appDir.mkpath("clips");
+    QString clipsDir = appDir.filePath("clips");
+    
+    // Alert log spills evicted alerts and snapshots here when over its memory budget
+    alertLog.setStorageDirectory(QDir(logsDir).filePath("alerts"));
+
+    // A single image provider serves every camera: "image://camera/<cameraId>/<frameSequence>"
+    CameraImageProvider *cameraImageProvider = new CameraImageProvider();
+    cameraImageProvider->setCameraManager(&cameraManager);
+    engine.addImageProvider("camera", cameraImageProvider);
+
+    // Alert snapshots: "image://alerts/thumb/<alertId>" and "image://alerts/full/<alertId>"
+    AlertSnapshotProvider *alertSnapshotProvider = new AlertSnapshotProvider();
+    alertSnapshotProvider->setAlertLogModel(&alertLog);
+    engine.addImageProvider("alerts", alertSnapshotProvider);
 
-    // Create and register image providers for each camera
-    for (int i = 1; i <= 4; ++i) {
-        if (cameraManager.cameraAvailable(i)) {
-            CameraImageProvider *provider = new CameraImageProvider();
+    // Wire every enabled camera into the alert log
+    for (CameraStream *stream : cameraManager.cameras()) {
+        stream->setEventClipDirectory(clipsDir);
+        
+        // Alerts only point at a clip once its file has been written
+        QObject::connect(stream, &CameraStream::eventClipSaved,
+                         &alertLog, &AlertLogModel::attachEventClip);
+        QObject::connect(stream, &CameraStream::eventClipFailed,
+                         &alertLog, &AlertLogModel::discardEventClip);
+        
+        // Connect snapshot captured signal to alert log (for manual snapshots)
+        QObject::connect(stream, &CameraStream::snapshotCaptured, 
+                         &alertLog, [&alertLog, stream](const QImage &image) {
+            alertLog.addSnapshotAlert(stream->cameraName(), image);
+        });
+        
+        // Connect motion detection to alert log
+        QObject::connect(stream, &CameraStream::motionDetected,
+                         &alertLog, [&alertLog, stream](double score, const QImage &frame, qint64 frameTimeMs) {
+            // Always create motion alert
+            QString message = QString("Motion detected (score: %1)").arg(
+                QString::number(score, 'f', 1));
+            alertLog.addMotionAlert(stream->cameraName(), message, "", stream->recordEventClip(frameTimeMs));
+            
+            // If auto-snapshot is enabled, also create a snapshot alert
+            if (stream->autoSnapshotOnMotion() && !frame.isNull()) {
+                alertLog.addSnapshotAlert(stream->cameraName(), frame);
+            }
+        });
+        
+        // Connect ROI motion detection to alert log
+        QObject::connect(stream, &CameraStream::roiMotionDetected,
+                         &alertLog, [&alertLog, stream](double score, const QImage &frame, qint64 frameTimeMs) {
+            // Always create ROI motion alert
+            QString message = QString("Motion in ROI (score: %1)").arg(
+                QString::number(score, 'f', 1));
+            alertLog.addRoiMotionAlert(stream->cameraName(), message, "", stream->recordEventClip(frameTimeMs));
+            
+            // If auto-snapshot is enabled, also create a snapshot alert
+            if (stream->autoSnapshotOnRoi() && !frame.isNull()) {
+                alertLog.addSnapshotAlert(stream->cameraName(), frame);
+            }
+        });
+        
+        // Connect tripwire crossing to alert log
+        QObject::connect(stream, &CameraStream::tripwireCrossed,
+                         &alertLog, [&alertLog, stream](int direction, const QImage &frame, qint64 frameTimeMs) {
+            // Always create tripwire alert
+            QString dirText = (direction > 0) ? "forward" : "backward";
+            QString message = QString("Tripwire crossed (%1)").arg(dirText);
+            alertLog.addTripwireAlert(stream->cameraName(), message, "", direction, -1,
+                                     stream->recordEventClip(frameTimeMs));
             
-            // Get the camera stream for this index
-            CameraStream *stream = nullptr;
-            switch(i) {
-                case 1: stream = qobject_cast<CameraStream*>(cameraManager.camera1()); break;
-                case 2: stream = qobject_cast<CameraStream*>(cameraManager.camera2()); break;
-                case 3: stream = qobject_cast<CameraStream*>(cameraManager.camera3()); break;
-                case 4: stream = qobject_cast<CameraStream*>(cameraManager.camera4()); break;
+            // If auto-snapshot is enabled, also create a snapshot alert
+            if (stream->autoSnapshotOnTripwire() && !frame.isNull()) {
+                alertLog.addSnapshotAlert(stream->cameraName(), frame);
             }
+        });
+        
+        // Connect track-based tripwire crossing to alert log
+        QObject::connect(stream, &CameraStream::trackCrossedTripwire,
+                         &alertLog, [&alertLog, stream](int trackId, const QString &label, const QString &direction,
+                                                const QImage &frame, qint64 frameTimeMs) {
+            // Create tripwire alert with track and direction info
+            QString message = QString("Track %1 (%2) crossed tripwire (%3)")
+                .arg(trackId)
+                .arg(label)
+                .arg(direction);
+            alertLog.addTripwireAlert(stream->cameraName(), message, "", 
+                                     direction == "left to right" ? 1 : -1, trackId,
+                                     stream->recordEventClip(frameTimeMs));
             
-            if (stream) {
-                provider->setCameraStream(stream);
-                engine.addImageProvider(QString("camera%1").arg(i), provider);
-                
-                // Connect frameChanged to trigger image provider updates
-                QObject::connect(stream, &CameraStream::frameChanged, [&engine, i]() {
-                    QString propName = QString("frameCounter%1").arg(i);
-                    engine.rootContext()->setContextProperty(propName, 
-                        engine.rootContext()->contextProperty(propName).toInt() + 1);
-                });
-                
-                // Connect snapshot captured signal to alert log (for manual snapshots)
-                QObject::connect(stream, &CameraStream::snapshotCaptured, 
-                                 &alertLog, [&alertLog, stream](const QImage &image) {
-                    alertLog.addSnapshotAlert(stream->cameraName(), image);
-                });
-                
-                // Connect motion detection to alert log
-                QObject::connect(stream, &CameraStream::motionDetected,
-                                 &alertLog, [&alertLog, stream](double score) {
-                    // Always create motion alert
-                    QString message = QString("Motion detected (score: %1)").arg(
-                        QString::number(score, 'f', 1));
-                    alertLog.addMotionAlert(stream->cameraName(), message, "");
-                    
-                    // If auto-snapshot is enabled, also create a snapshot alert
-                    if (stream->autoSnapshotOnMotion() && !stream->frame().isNull()) {
-                        alertLog.addSnapshotAlert(stream->cameraName(), stream->frame());
-                    }
-                });
-                
-                // Connect ROI motion detection to alert log
-                QObject::connect(stream, &CameraStream::roiMotionDetected,
-                                 &alertLog, [&alertLog, stream](double score) {
-                    // Always create ROI motion alert
-                    QString message = QString("Motion in ROI (score: %1)").arg(
-                        QString::number(score, 'f', 1));
-                    alertLog.addRoiMotionAlert(stream->cameraName(), message, "");
-                    
-                    // If auto-snapshot is enabled, also create a snapshot alert
-                    if (stream->autoSnapshotOnRoi() && !stream->frame().isNull()) {
-                        alertLog.addSnapshotAlert(stream->cameraName(), stream->frame());
-                    }
-                });
-                
-                // Connect tripwire crossing to alert log
-                QObject::connect(stream, &CameraStream::tripwireCrossed,
-                                 &alertLog, [&alertLog, stream](int direction) {
-                    // Always create tripwire alert
-                    QString dirText = (direction > 0) ? "forward" : "backward";
-                    QString message = QString("Tripwire crossed (%1)").arg(dirText);
-                    alertLog.addTripwireAlert(stream->cameraName(), message, "", direction);
-                    
-                    // If auto-snapshot is enabled, also create a snapshot alert
-                    if (stream->autoSnapshotOnTripwire() && !stream->frame().isNull()) {
-                        alertLog.addSnapshotAlert(stream->cameraName(), stream->frame());
-                    }
-                });
-                
-                // Connect track-based tripwire crossing to alert log
-                QObject::connect(stream, &CameraStream::trackCrossedTripwire,
-                                 &alertLog, [&alertLog, stream](int trackId, const QString &label, const QString &direction) {
-                    // Create tripwire alert with track and direction info
-                    QString message = QString("Track %1 (%2) crossed tripwire (%3)")
-                        .arg(trackId)
-                        .arg(label)
-                        .arg(direction);
-                    alertLog.addTripwireAlert(stream->cameraName(), message, "", 
-                                             direction == "left to right" ? 1 : -1);
-                    
-                    // If auto-snapshot is enabled, also create a snapshot alert
-                    if (stream->autoSnapshotOnTripwire() && !stream->frame().isNull()) {
-                        alertLog.addSnapshotAlert(stream->cameraName(), stream->frame());
-                    }
-                });
-                
-                // Connect loitering detection to alert log
-                QObject::connect(stream, &CameraStream::loiteringDetected,
-                                 &alertLog, [&alertLog, stream](int trackId, const QString &label, qint64 durationMs) {
-                    double durationSec = durationMs / 1000.0;
-                    QString message = QString("Track %1 (%2) loitering: stayed in ROI for %3 seconds")
-                        .arg(trackId)
-                        .arg(label)
-                        .arg(durationSec, 0, 'f', 1);
-                    alertLog.addLoiteringAlert(stream->cameraName(), message, "");
-                    
-                    // Auto-snapshot if ROI snapshot enabled
-                    if (stream->autoSnapshotOnRoi() && !stream->frame().isNull()) {
-                        alertLog.addSnapshotAlert(stream->cameraName(), stream->frame());
-                    }
-                });
-                
-                // Initialize frame counter
-                engine.rootContext()->setContextProperty(QString("frameCounter%1").arg(i), 0);
+            // If auto-snapshot is enabled, also create a snapshot alert
+            if (stream->autoSnapshotOnTripwire() && !frame.isNull()) {
+                alertLog.addSnapshotAlert(stream->cameraName(), frame);
             }
-        }
+        });
+        
+        // Connect loitering detection to alert log
+        QObject::connect(stream, &CameraStream::loiteringDetected,
+                         &alertLog, [&alertLog, stream](int trackId, const QString &label, qint64 durationMs,
+                                                const QImage &frame, qint64 frameTimeMs) {
+            double durationSec = durationMs / 1000.0;
+            QString message = QString("Track %1 (%2) loitering: stayed in ROI for %3 seconds")
+                .arg(trackId)
+                .arg(label)
+                .arg(durationSec, 0, 'f', 1);
+            alertLog.addLoiteringAlert(stream->cameraName(), message, "", trackId,
+                                      stream->recordEventClip(frameTimeMs));
+            
+            // Auto-snapshot if ROI snapshot enabled
+            if (stream->autoSnapshotOnRoi() && !frame.isNull()) {
+                alertLog.addSnapshotAlert(stream->cameraName(), frame);
+            }
+        });
     }
 
     // Expose camera manager to QML
@@ -166,28 +170,40 @@ int main(int argc, char *argv[])
     // HTTP SERVER SETUP
     // ============================================================================
     
-    // Create HTTP server
-    HttpServer *httpServer = new HttpServer(&app);
+    // Create HTTP server; it does its socket I/O on a thread of its own so
+    // slow clients and large responses never stall the UI
+    QThread httpThread;
+    httpThread.setObjectName("HttpServer");
+    HttpServer *httpServer = new HttpServer();
     
     // Set data providers
     httpServer->setAlertLogModel(&alertLog);
     httpServer->setCameraManager(&cameraManager);
     
+    // Per client address, and a NAT puts every dashboard behind it in one
+    // bucket: a dashboard polling 8 cameras at 5 Hz makes 40 requests a second
+    httpServer->setRateLimit(200.0, 400.0);
+    
+    httpServer->moveToThread(&httpThread);
+    QObject::connect(&httpThread, &QThread::finished, httpServer, &QObject::deleteLater);
+    httpThread.start();
+    
     // Start server on port 8080
     if (httpServer->start(8080)) {
         std::cout << "✓ HTTP API available at:" << std::endl;
         std::cout << "  http://localhost:8080/ping" << std::endl;
         std::cout << "  http://localhost:8080/alerts" << std::endl;
+        std::cout << "  http://localhost:8080/alerts/stream" << std::endl;
         std::cout << "  http://localhost:8080/cameras" << std::endl;
-        std::cout << "  http://localhost:8080/cameras/cam0/snapshot" << std::endl;
-        std::cout << "  http://localhost:8080/alerts/<id>/snapshot" << std::endl;
+        std::cout << "  http://localhost:8080/cameras/<id>/snapshot" << std::endl;
+        std::cout << "  http://localhost:8080/cameras/<id>/stream" << std::endl;
+        std::cout << "  http://localhost:8080/mosaic[?cameras=<id>,<id>&width=&height=&fps=]" << std::endl;
+        std::cout << "  http://localhost:8080/alerts/<id>/snapshot[?size=thumb]" << std::endl;
+        std::cout << "  http://localhost:8080/metrics" << std::endl;
     } else {
         std::cerr << "✗ Failed to start HTTP server" << std::endl;
     }
     
-    // Expose HTTP server to QML (optional, for status display)
-    engine.rootContext()->setContextProperty("httpServer", httpServer);
-    
     // ============================================================================
 
     // Load the main QML file using the QML module URI path
@@ -214,9 +230,17 @@ int main(int argc, char *argv[])
     // Check if engine loaded successfully
     if (engine.rootObjects().isEmpty()) {
         std::cerr << "Error: No root objects found in QML" << std::endl;
+        httpThread.quit();
+        httpThread.wait();
         return -1;
     }
 
     // Start the event loop
-    return app.exec();
+    const int result = app.exec();
+    
+    // Stop serving before the models the server reads from go away
+    httpThread.quit();
+    httpThread.wait();
+    
+    return result;
 }
\ No newline at end of file